@@ -0,0 +1,75 @@
+/*
+ * arena.h                                                                   
+ * =======                                                                   
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for arena.c. Contains the definition of the bump allocator    
+ *     that peptides and their sequences are allocated from and released     
+ *     with in bulk.                                                         
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h> //size_t
+
+#define ARENA_BLOCK (1 << 20) //bytes of a default arena block
+
+/*
+ * arenaBlock - A block of memory handed out front to back. data is declared
+ *     as double so allocations from it are suitably aligned.
+ */
+typedef struct arenaBlock {
+	struct arenaBlock *next;
+	size_t used; //bytes of data handed out
+	size_t size; //bytes of data
+	double data[];
+} ArenaBlock, *ArenaBlockPointer;
+
+/*
+ * arena - A list of blocks, newest first, that is only freed as a whole. An
+ *     arena is not locked so each thread should allocate from its own.
+ */
+typedef struct arena {
+	ArenaBlockPointer blocks;
+	size_t blockSize;
+} Arena, *ArenaPointer;
+
+/*
+ * newArena - Allocate an empty arena whose blocks hold blockSize bytes, 0
+ *     picks ARENA_BLOCK. Return NULL if out of memory.
+ */
+ArenaPointer newArena(size_t blockSize);
+
+/*
+ * delArena - Free the arena and every allocation made from it. Return NULL.
+ */
+ArenaPointer delArena(ArenaPointer ap);
+
+/*
+ * arenaAlloc - Return size bytes from the arena, NULL if out of memory. If ap
+ *     is NULL the memory comes from malloc and must be freed by the caller.
+ */
+void *arenaAlloc(ArenaPointer ap, size_t size);
+
+/*
+ * arenaString - Return a copy of the string allocated with arenaAlloc.
+ */
+char *arenaString(ArenaPointer ap, const char *string);
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * calibrate.h                                                               
+ * ===========                                                               
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for calibrate.c. Contains the definition of a per-file m/z    
+ *     calibration and functions for fitting and applying it.                
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef CALIBRATE_H
+#define CALIBRATE_H
+
+#include "mzXML.h" //MZXMLPointer
+#include "peptide.h" //PeptidePointer
+#include "hits.h" //HitStorePointer
+
+/*
+ * calibration - The relative m/z error of a single LC-MS run modelled as
+ *     intercept + rtSlope*(rt - rtMean) + mzSlope*(mz - mzMean) and the
+ *     tolerance to search the corrected m/z with.
+ */
+typedef struct calibration {
+	double intercept;
+	double rtSlope;
+	double mzSlope;
+	double rtMean;
+	double mzMean;
+	double tolerance;
+	int points;
+} Calibration, *CalibrationPointer;
+
+/*
+ * newCalibration - Measure the m/z error of the precursors of the ms2 scans
+ *     of the mzXML identified in the peptides' search results in the
+ *     preceding ms1 scan and fit a calibration to them. The scans are the
+ *     hits of ms2hits in column, the filelist position of the mzXML. Return a
+ *     pointer to the new calibration, NULL if there were too few precursors
+ *     or an error occured.
+ */
+CalibrationPointer newCalibration(MZXMLPointer mzXML, HitStorePointer ms2hits,
+	int column, PeptidePointer *peptides, int peptideCount);
+
+/*
+ * delCalibration - Free all memory allocated for the Calibration.
+ */
+CalibrationPointer delCalibration(CalibrationPointer cal);
+
+/*
+ * calibrateMz - Return the mz at which a theoretical mz is expected to be
+ *     observed at the retention time, the mz itself if cal is NULL.
+ */
+float calibrateMz(CalibrationPointer cal, float mz, float rt);
+
+/*
+ * calibratedTolerance - Return the relative tolerance to search calibrated
+ *     mzs with, ppmCutOff if cal is NULL.
+ */
+double calibratedTolerance(CalibrationPointer cal);
+
+#endif
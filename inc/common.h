@@ -33,10 +33,18 @@
  */
 int comparedouble (const void * a, const void * b);
 
+/*
+ * selectRank - Return the value of the passed rank, counting from 0 at the
+ *     smallest, among count values. values is partially reordered in place.
+ */
+double selectRank(double *values, int count, int rank);
+
 /*
  * median - Return the median value in a list of doubles with size elements. 
  *     If the list is comprised only of numbers equal to or greater than 0 the
- *     median will be of the non-zero elements only.         
+ *     median will be of the non-zero elements only. The median is 0 when
+ *     fewer than three values remain or their interquartile range exceeds
+ *     250. list is left untouched.
  */
 double median(double *list, int size);
 
@@ -48,15 +56,11 @@ double median(double *list, int size);
 float pearson(float *y, float *x, float *corr);
 
 /*
- * new2Darray - Allocate memory for a two dimensional double array.
- */
-double **new2Darray(int x, int y);
-
-/*
- * del2Darray - Free memory allocated for a two dimensional double array. The
- *     passed integer specifies the first dimension of the array.
+ * nextToken - Reentrant strtok. Return the next token of the string *cursor
+ *     delimited by any character of delim and advance *cursor past it, NULL
+ *     if there are no tokens left. Pass the string to tokenize in *cursor.
  */
-double **del2Darray(double **array, int x);
+char *nextToken(char **cursor, const char *delim);
 
 #endif
 
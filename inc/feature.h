@@ -0,0 +1,78 @@
+/*
+ * feature.h                                                                 
+ * =========                                                                 
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for feature.c. Contains the definition of isotope cluster     
+ *     features detected in the ms1 scans of a single LC-MS run and functions
+ *     for detecting, caching and matching them.                             
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef FEATURE_H
+#define FEATURE_H
+
+#include "xic.h" //XicStorePointer
+
+/*
+ * feature - An isotope cluster of a single charge followed over adjacent ms1
+ *     scans. mz is that of the lightest isotope of the cluster and mass the
+ *     matching neutral mass. first and last are the first and last store scans
+ *     the cluster was seen in and apex the store scan it was most intense in.
+ */
+typedef struct feature {
+	double mass;
+	float mz;
+	float apexRT;
+	float apexIntensity;
+	int charge;
+	int apex;
+	int first;
+	int last;
+} Feature, *FeaturePointer;
+
+/*
+ * featureList - The features of a single LC-MS run sorted by mass.
+ */
+typedef struct featureList {
+	int count;
+	struct feature *features;
+} FeatureList, *FeatureListPointer;
+
+/*
+ * findFeatures - Detect the isotope clusters of every scan in the store and
+ *     link them across scans into features. If a cache written for the file
+ *     with the current search parameters exists it is read instead, otherwise
+ *     the detected features are cached as <filename>.features. Return a
+ *     pointer to the new feature list, NULL if an error occured.
+ */
+FeatureListPointer findFeatures(XicStorePointer xs, char *filename);
+
+/*
+ * delFeatureList - Free all memory allocated for the FeatureList.
+ */
+FeatureListPointer delFeatureList(FeatureListPointer fl);
+
+/*
+ * featureRange - Find the features whose mass is within tolerance (relative)
+ *     of the mass. The first feature is stored in first and one past the last
+ *     feature in last, first == last if there are none.
+ */
+void featureRange(FeatureListPointer fl, double mass, double tolerance,
+	int *first, int *last);
+
+#endif
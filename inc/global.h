@@ -45,6 +45,14 @@ extern char *pepXMLdir;
 extern char *maxQuant;
 extern char *fuse;
 extern bool ignoreModSite;
+extern int chargeWindow;
+extern bool useFeatures;
+extern bool recalibrate;
+extern bool streaming;
+extern int memBudget;
+extern int isotopeModel;
+extern int alignModel;
+extern char *isotopeCache;
 extern char **dataList;
 extern size_t dataCount;
 
@@ -0,0 +1,89 @@
+/*
+ * graph.h                                                                   
+ * =======                                                                   
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for graph.c. Contains the definition of a graph of pipeline   
+ *     stages and their dependencies which is run on the thread pool.        
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <pthread.h>
+
+#define MAX_DEPENDENTS 8 //stages that may wait on a single stage
+
+/*
+ * StageFunc - The work of a single pipeline stage.
+ */
+typedef void (*StageFunc)(void *arg);
+
+/*
+ * stage - A pipeline stage, the number of stages it still waits on and the
+ *     stages waiting on it.
+ */
+typedef struct stage {
+	char *name;
+	StageFunc run;
+	void *arg;
+	int index;
+	int pending;
+	int dependentCount;
+	struct stage *dependents[MAX_DEPENDENTS];
+} Stage, *StagePointer;
+
+/*
+ * graph - The stages of a pipeline.
+ */
+typedef struct graph {
+	int count;
+	int size;
+	struct stage **stages;
+	pthread_mutex_t lock;
+} Graph, *GraphPointer;
+
+/*
+ * newGraph - Allocate an empty graph. Return a pointer to the new graph, NULL
+ *     if an error occured.
+ */
+GraphPointer newGraph(void);
+
+/*
+ * delGraph - Free all memory allocated for the graph and its stages.
+ */
+GraphPointer delGraph(GraphPointer gp);
+
+/*
+ * addStage - Add a stage running run(arg) to the graph. Return a pointer to
+ *     the new stage. Exits if memory could not be allocated.
+ */
+StagePointer addStage(GraphPointer gp, char *name, StageFunc run, void *arg);
+
+/*
+ * stageAfter - Make the stage wait for the dependency to finish.
+ */
+void stageAfter(StagePointer stage, StagePointer dependency);
+
+/*
+ * runGraph - Run every stage of the graph on the thread pool, each once all
+ *     of its dependencies have finished. Return once all stages finished.
+ */
+void runGraph(GraphPointer gp);
+
+#endif
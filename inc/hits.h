@@ -0,0 +1,130 @@
+/*
+ * hits.h                                                                    
+ * ======                                                                    
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for hits.c. Contains the compressed sparse row store of the   
+ *     ms1 and ms2 hits of every peptide in every spectra file, and the      
+ *     buffers ms1 hits are gathered in while a file is searched.            
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef HITS_H
+#define HITS_H
+
+#include <stdbool.h>
+
+/*
+ * hitStore - Hits of every peptide row in every file of the filelist in
+ *     compressed sparse row form. The runs of row r are runStart[r] up to
+ *     runStart[r+1], ordered by filelist column, and the hits of run u are
+ *     hitStart[u] up to hitStart[u+1], ordered by scan. Hit h keeps width
+ *     intensities (and correlations) from intensity[h*width] on; one per
+ *     charge for ms1, the total ion current for ms2 which has no corr.
+ */
+typedef struct hitStore {
+	int rowCount;
+	int runCount;
+	int hitCount;
+	int width;
+	int *runStart; //rowCount+1 run offsets
+	int *runColumn; //filelist column of every run
+	int *hitStart; //runCount+1 hit offsets
+	int *scanNum;
+	double *rt;
+	float *intensity;
+	float *corr; //NULL unless the store was created with correlations
+} HitStore, *HitStorePointer;
+
+/*
+ * hitKey - An unordered hit of a peptide row in a scan of a filelist column.
+ */
+typedef struct hitKey {
+	int row;
+	int column;
+	int scanNum;
+} HitKey, *HitKeyPointer;
+
+/*
+ * hitBuffer - The hits of one peptide in the file being searched, kept in
+ *     increasing scan order until they are packed into a HitStore.
+ */
+typedef struct hitBuffer {
+	int count;
+	int size;
+	int *scanNum;
+	float *intensity; //width per hit
+	float *corr; //width per hit
+} HitBuffer, *HitBufferPointer;
+
+/*
+ * newHitStore - Allocate a store for the passed number of rows, runs and
+ *     hits of width values each, with a correlation column if withCorr.
+ *     Offsets are zeroed. Return NULL if out of memory.
+ */
+HitStorePointer newHitStore(int rowCount, int runCount, int hitCount,
+	int width, bool withCorr);
+
+/*
+ * delHitStore - Free all memory allocated for the store. Return NULL.
+ */
+HitStorePointer delHitStore(HitStorePointer hs);
+
+/*
+ * keyedHits - Sort the keys by row, column and scan and pack every distinct
+ *     key into a new store of width 1 with zeroed retention times and
+ *     intensities. Keys with a negative row or column are skipped. Return
+ *     NULL if out of memory.
+ */
+HitStorePointer keyedHits(HitKeyPointer keys, int count, int rowCount);
+
+/*
+ * findRun - Return the run of row in column, -1 if the row has no hits there.
+ */
+int findRun(HitStorePointer hs, int row, int column);
+
+/*
+ * bufferHit - Add a hit to the buffer keeping it in increasing scan order.
+ *     A scan that is already buffered keeps its first hit. Return 0 on
+ *     success, -1 if out of memory.
+ */
+int bufferHit(HitBufferPointer hb, int width, int scanNum, float *intensity,
+	float *corr);
+
+/*
+ * freeBuffer - Free the hits of the buffer and empty it.
+ */
+void freeBuffer(HitBufferPointer hb);
+
+/*
+ * bufferedHits - Pack the buffers of rowCount rows, buffers[r] holding the
+ *     hits of row r in filelist column, into a new store with correlations
+ *     and free the buffers' contents. Retention times are zeroed. Return NULL
+ *     if out of memory.
+ */
+HitStorePointer bufferedHits(HitBufferPointer buffers, int rowCount,
+	int column, int width);
+
+/*
+ * mergeHits - Join stores of the same rows and width, each passed in
+ *     filelist column order, into a new store and free them. Return NULL if
+ *     out of memory.
+ */
+HitStorePointer mergeHits(HitStorePointer *parts, int partCount,
+	int rowCount, int width, bool withCorr);
+
+#endif
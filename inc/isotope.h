@@ -34,6 +34,32 @@
 #define ISOTOPE_COUNT 32 //the number of isotopes to track
 #define COLLECTION_SIZE 128 //number of isotopic patterns in collection
 #define AMINO_ACIDS "ARNDCQEGHILKMFPSTUWYV" //legal amino acids
+#define AGGREGATE_COUNT 16 //nominal isotopes tracked from a composition
+
+/*
+ * isotopeModel - ways of computing the isotopic pattern of a peptide.
+ */
+typedef enum isotopeModel {
+	COMPOSITION_MODEL, //aggregated isotopes of the elemental composition
+	CONVOLUTION_MODEL, //per atom convolution of residue patterns
+	AVERAGINE_MODEL //averagine isotopes at the peptide's monoisotopic mass
+}IsotopeModel;
+
+/*
+ * element - index of each element count in an elemental composition.
+ */
+typedef enum element {
+	CARBON,
+	HYDROGEN,
+	NITROGEN,
+	OXYGEN,
+	PHOSPHORUS,
+	SULFUR,
+	SELENIUM,
+	CARBON13, //heavy
+	NITROGEN15, //heavy
+	ELEMENT_COUNT
+}Element;
 
 /*
  * isotopicPattern - the isotopic pattern of an atom or molecule. A properly  
@@ -45,6 +71,19 @@ typedef struct isotopicPattern{
 	float *mass;
 }IsotopicPattern, *IsotopicPatternPointer;
 
+/*
+ * prefixStack - The isotopic patterns of every prefix of the last encoded
+ *     peptide made with makePeptidePrefix. patterns[i] is the pattern of the
+ *     first i codes. Peptides sharing a prefix with the last one only
+ *     convolve their differing suffix.
+ */
+typedef struct prefixStack{
+	unsigned char *codes;
+	int length;
+	int size;
+	struct isotopicPattern **patterns;
+}PrefixStack, *PrefixStackPointer;
+
 /*
  * delIsotopicPattern - Free all memory allocated for the IsotopicPattern.
  */
@@ -70,13 +109,70 @@ void newIPCollection(IsotopicPatternPointer **IPCollection);
 IsotopicPatternPointer* delIPCollection(IsotopicPatternPointer *IPCollection);
 
 /*
- * makePeptide - Create an IsotopicPattern for a peptide by parsing a string
- *     representation of the peptide. Return a pointer to that peptide. Current
+ * encodePeptide - Parse the string representation of a peptide into the
+ *     IPCollection index of each of its residues and mods in order, writing
+ *     them to codes which must hold strlen(sequence) entries. Current
  *     implementation supports 21 amino acids with carbidomethyl cysteine, and
- *     (ac), (ph), (ox) MaxQuant mods.
+ *     (ac), (ph), (ox) MaxQuant mods. Return the number of codes, -1 if the
+ *     sequence could not be parsed.
+ */
+int encodePeptide(char *sequence, unsigned char *codes);
+
+/*
+ * makePeptide - Create an IsotopicPattern for a peptide from its count codes
+ *     made by encodePeptide. Return a pointer to that peptide.
  */
 IsotopicPatternPointer makePeptide(
-	IsotopicPatternPointer *IPCollection, char *sequence);
+	IsotopicPatternPointer *IPCollection, const unsigned char *codes,
+	int count);
+
+/*
+ * newPrefixStack - Create an empty prefix stack. Return a pointer to the new
+ *     stack, NULL if an error occured.
+ */
+PrefixStackPointer newPrefixStack(void);
+
+/*
+ * delPrefixStack - Free all memory allocated for the PrefixStack and the
+ *     patterns it holds.
+ */
+PrefixStackPointer delPrefixStack(PrefixStackPointer ps);
+
+/*
+ * makePeptidePrefix - Create the same IsotopicPattern as makePeptide, reusing
+ *     the pattern of the longest prefix shared with the previous sequence made
+ *     with the stack. The stack then holds the prefixes of this sequence.
+ */
+IsotopicPatternPointer makePeptidePrefix(IsotopicPatternPointer *IPCollection,
+	PrefixStackPointer ps, const unsigned char *codes, int count);
+
+/*
+ * peptideComposition - Count the atoms of each element in the peptide given by
+ *     its count codes made by encodePeptide.
+ */
+void peptideComposition(const unsigned char *codes, int count,
+	int *composition);
+
+/*
+ * makeComposition - Create an IsotopicPattern holding the isotopicStates most
+ *     intense aggregated isotopes of a molecule with the passed elemental
+ *     composition. Each isotope's mass is the intensity weighted mean mass of
+ *     the isotopologues with that nominal mass.
+ */
+IsotopicPatternPointer makeComposition(int *composition);
+
+/*
+ * initAveragine - Tabulate the aggregated isotopes of averagine over the range
+ *     of peptide masses. Must be called before makeAveragine.
+ */
+void initAveragine(void);
+
+/*
+ * makeAveragine - Create an IsotopicPattern for a molecule with the passed
+ *     elemental composition from the averagine isotopes interpolated at its
+ *     exact monoisotopic mass.
+ */
+IsotopicPatternPointer makeAveragine(int *composition);
 
 #endif
 
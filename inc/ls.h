@@ -25,12 +25,32 @@
 #ifndef LS_H
 #define LS_H
 
+#include "matrix.h" //MatrixPointer
+
+/*
+ * alignModel - ways of fitting the retention times of a run to the medians.
+ */
+typedef enum alignModel {
+	LINEAR_ALIGN, //least squares line
+	ROBUST_ALIGN, //least squares line reweighted against outliers
+	LOWESS_ALIGN //lowess curve, extended past its ends along the line
+}AlignModel;
+
+#define LOWESS_KNOTS 32 //most points a run's lowess curve is kept at
+
+/*
+ * Columns of a run's parameters with lowess: the line's intercept and slope,
+ *     the knot count, then the knots' medians and run retention times.
+ */
+#define LOWESS_PARAMS (3 + 2 * LOWESS_KNOTS)
+
 /*
  * leastSquares - Given a retention time table and a vector of median        
  *     retention times fits a linear function for each median-run pair and
- *     return the regression parameters as a two dimensional array. 
+ *     return the regression parameters as a fileCount by 2 matrix, or by
+ *     LOWESS_PARAMS with a lowess curve. Runs are fitted concurrently. 
  */
-double **leastSquares(double **rt, double *median, int peptideCount,
+MatrixPointer leastSquares(MatrixPointer rt, double *median, int peptideCount,
 	int fileCount);
 
 /*
@@ -38,8 +58,8 @@ double **leastSquares(double **rt, double *median, int peptideCount,
  *     time vectors and regressed parameters for linear functions align runs
  *     storing final results in the ms2 retention time table.
  */
-void align(double **ms2rt, double **ms1rt, double *ms2median, 
-	double *ms1median, double **ms2params, double **ms1params,
+void align(MatrixPointer ms2rt, MatrixPointer ms1rt, double *ms2median, 
+	double *ms1median, MatrixPointer ms2params, MatrixPointer ms1params,
 	int peptideCount, int fileCount);
 
 #endif
@@ -0,0 +1,72 @@
+/*
+ * matrix.h                                                                  
+ * ========                                                                  
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for matrix.c. Contains the row major matrix of doubles used   
+ *     for every peptide or protein by file table.                           
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stdbool.h>
+
+/*
+ * matrix - A rows by cols table of doubles in a single cache line aligned
+ *     allocation. Row r starts stride doubles after row r-1. Rows of at least
+ *     a cache line are padded to a whole number of lines so each starts on a
+ *     line of its own; narrower rows are packed with a stride of cols, since
+ *     with few files padding would take up to 8 times the memory of the
+ *     values and rows then share lines.
+ */
+typedef struct matrix {
+	int rows;
+	int cols;
+	int stride;
+	double *data;
+} Matrix, *MatrixPointer;
+
+/*
+ * newMatrix - Allocate a rows by cols matrix of zeros. Return NULL if out of
+ *     memory.
+ */
+MatrixPointer newMatrix(int rows, int cols);
+
+/*
+ * delMatrix - Free all memory allocated for the matrix. Return NULL.
+ */
+MatrixPointer delMatrix(MatrixPointer mp);
+
+/*
+ * matrixRow - Return a pointer to the cols values of row.
+ */
+double *matrixRow(MatrixPointer mp, int row);
+
+/*
+ * matrixColumn - Copy the rows values of column into values.
+ */
+void matrixColumn(MatrixPointer mp, int column, double *values);
+
+/*
+ * compactRows - Drop the rows whose keep entry is false, moving the rows kept
+ *     up in order. Return the number of rows left.
+ */
+int compactRows(MatrixPointer mp, const bool *keep);
+
+#endif
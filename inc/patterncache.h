@@ -0,0 +1,95 @@
+/*
+ * patterncache.h                                                            
+ * ==============                                                            
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for patterncache.c. Contains the definition of the cache of   
+ *     isotopic patterns keyed by elemental composition that is shared by the
+ *     threads generating peptide isotopic patterns.                         
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef PATTERNCACHE_H
+#define PATTERNCACHE_H
+
+#include "isotope.h" //IsotopicPatternPointer, ELEMENT_COUNT
+
+#include <pthread.h>
+
+#define CACHE_SHARDS 64 //independently locked parts of a pattern cache
+
+/*
+ * patternEntry - The isotopic pattern of a single elemental composition.
+ */
+typedef struct patternEntry {
+	int composition[ELEMENT_COUNT];
+	float *intensity;
+	float *mass;
+	struct patternEntry *next;
+} PatternEntry, *PatternEntryPointer;
+
+/*
+ * patternShard - A chained hash table holding the compositions that hash to
+ *     the shard, guarded by its own lock.
+ */
+typedef struct patternShard {
+	pthread_mutex_t lock;
+	int size;
+	int count;
+	PatternEntryPointer *buckets;
+} PatternShard, *PatternShardPointer;
+
+/*
+ * patternCache - Isotopic patterns of isotopicStates isotopes keyed by
+ *     elemental composition.
+ */
+typedef struct patternCache {
+	PatternShard shards[CACHE_SHARDS];
+} PatternCache, *PatternCachePointer;
+
+/*
+ * newPatternCache - Create an empty pattern cache. Return a pointer to the new
+ *     cache, NULL if an error occured.
+ */
+PatternCachePointer newPatternCache(void);
+
+/*
+ * delPatternCache - Free all memory allocated for the PatternCache.
+ */
+PatternCachePointer delPatternCache(PatternCachePointer pc);
+
+/*
+ * cachedComposition - Return a new IsotopicPattern for the composition,
+ *     computing it with makeComposition and caching it if it is not already
+ *     in the cache. Safe to call from several threads at once.
+ */
+IsotopicPatternPointer cachedComposition(PatternCachePointer pc,
+	int *composition);
+
+/*
+ * readPatternCache - Add the patterns saved at path to the cache if they were
+ *     written for the current number of isotopic states. Return the number of
+ *     patterns read.
+ */
+int readPatternCache(PatternCachePointer pc, char *path);
+
+/*
+ * writePatternCache - Save every pattern of the cache at path.
+ */
+void writePatternCache(PatternCachePointer pc, char *path);
+
+#endif
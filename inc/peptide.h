@@ -18,7 +18,7 @@
  *                                                                           
  * Header file for peptide.c. Contains function declartions for parsing      
  *     search engine results and structs for storing them. A set of discovered
- *     peptides is maintained as a red-black tree. 
+ *     peptides is maintained in a hash table keyed on sequence.
  *                                                                           
  * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
  */
@@ -26,56 +26,68 @@
 #ifndef PEPTIDE_H
 #define PEPTIDE_H
 
-/*
- * nodeColour - possible colours for nodes of a red-black tree
- */
-typedef enum nodeColour {
-	RED,
-	BLACK
-}NodeColour;
+#include <stdint.h> //uint32_t
+#include <stdbool.h>
 
-/*
- * scanNode - A node for a linked list containing the scan numbers where a   
- *     peptide was detected for a given spectra file.                 
- */
-typedef struct scanNode {
-	int scanNum;
-	double rt;
-	float *corr; //stores correlation for different charge states for ms1
-	/*stores intensity for different charge states for ms1,
-	total ion current for ms2**/
-	float *intensity; 
-	struct scanNode *next;
-} ScanNode, *ScanNodePointer;
+struct mzxml;
+struct arena;
+struct fileRegistry;
+struct hitStore;
+struct matrix;
 
 /*
  * spectraFileNode - A node for a linked list containing the spectra files  
- *     where a given peptide was detected in at least one scan.
+ *     searched, the filelist whose order gives the columns of every table.
  */
 typedef struct spectraFileNode {
-	char *rawFile;
-	struct scanNode *scans;
+	char *rawFile; //name interned by the run's FileRegistry
+	int fileId; //id of rawFile in the FileRegistry
 	struct spectraFileNode *next;
 } SpectraFileNode, *SpectraFileNodePointer;
 
 /*
- * peptide - A node for a red-black tree containing the peptides detected in a  
- *     tandem mass spectra search.
+ * peptide - A peptide detected in a tandem mass spectra search.
  */
 typedef struct peptide {
 	char* sequence;
+	char *stripped; //sequence without mods or label marks
+	unsigned char *codes; //IPCollection index of every residue and mod
+	int codeCount; //-1 if the sequence could not be parsed
+	bool heavy; //sequence is marked as SILAC heavy by a leading '*'
 
 	struct isotopicPattern *ip;
-	struct spectraFileNode *spectraFiles;
-	struct spectraFileNode *ms1SpectraFiles;
-
-	NodeColour colour;
-	struct peptide *parent;
-	struct peptide *left;
-	struct peptide *right;
+	int row; //row of the peptide's hits in hit stores, -1 once removed
+	struct ms1Summary *ms1Summaries; //per file ms1 hit summaries if streaming
+	unsigned int charges; //bit mask of charges seen in ms2 identifications
 } Peptide, *PeptidePointer;
 
-extern Peptide TNILL; //Sentinel for red-black tree
+/*
+ * psm - A peptide spectrum match, the ms2 scan of a registered spectra file
+ *     in which a peptide was identified.
+ */
+typedef struct psm {
+	struct peptide *pep;
+	int fileId;
+	int scanNum;
+} Psm, *PsmPointer;
+
+/*
+ * peptideStore - Open addressing hash table of the peptides detected in a
+ *     search, keyed on sequence. Each occupied slot keeps the hash of its
+ *     sequence so probes only compare strings whose hashes agree.
+ */
+typedef struct peptideStore {
+	PeptidePointer *slots; //NULL where empty
+	uint32_t *hashes;
+	int size; //a power of two
+	int count;
+	struct arena **arenas; //per pool worker, hold the peptides
+	int arenaCount;
+	struct fileRegistry *files; //ids of the spectra files peptides are in
+	PsmPointer psms; //every identification in a registered file
+	int psmCount;
+	int psmSize;
+} PeptideStore, *PeptideStorePointer;
 
 /*
  * delSpectraFileList - Free all memory allocated for the linked list of 
@@ -91,53 +103,69 @@ SpectraFileNodePointer delSpectraFileList(SpectraFileNodePointer sfnp);
 void printPeptides(PeptidePointer *pp, int peptideCount);
 
 /*
- * delPeptideList - Free all memory allocated for the peptide tree.
- *     Return pointer to tree which should be NULL.
+ * newPeptideStore - Allocate an empty peptide store. Return NULL if out of
+ *     memory.
+ */
+PeptideStorePointer newPeptideStore(void);
+
+/*
+ * delPeptideStore - Free all memory allocated for the peptide store and its
+ *     peptides. Return NULL.
+ */
+PeptideStorePointer delPeptideStore(PeptideStorePointer store);
+
+/*
+ * storeArena - Return the arena of the store that the calling pool worker
+ *     allocates peptides from.
  */
-PeptidePointer delPeptideList(PeptidePointer pp);
+struct arena *storeArena(PeptideStorePointer store);
 
 /*
- * parseMaxQuant - Given a MaxQuant msms.txt file populate a peptide tree or 
- *     return NULL if something goes wrong.                                  
+ * parseMaxQuant - Given a MaxQuant msms.txt file populate the peptide store
+ *     and return it.
  */
-PeptidePointer parseMaxQuant(char *filename, PeptidePointer pp);
+PeptideStorePointer parseMaxQuant(char *filename, PeptideStorePointer store);
 
 /*
- * addPeptide - Add a new peptide to the red-bleack tree of peptides. Peptides
- *     will be added in increasing order (according to strcmp). The current 
- *     implementation includes modifications when sorting.
+ * addPeptide - Record an identification of sequence in the peptide store,
+ *     adding a new peptide if the sequence has not been seen. Sequences
+ *     include their modifications. The charge of the identification is
+ *     recorded if known, pass 0 otherwise.
  */
-PeptidePointer addPeptide(PeptidePointer root, char *rawFile, int scanNum,
-	char *sequence);
+void addPeptide(PeptideStorePointer store, char *rawFile, int scanNum,
+	char *sequence, int charge);
 
 /*
- * stripMods - Returns a string representation of the passed peptide with all
- *     modifications removed.
+ * removePeptide - Remove the peptide from the store and free its heap memory.
+ *     The peptide itself is released with the store's arenas.
  */
-char *stripMods(char *moddedPeptide);
+void removePeptide(PeptideStorePointer store, PeptidePointer pp);
 
 /*
  * Generate isotopic patterns for all peptides in the array of peptidePointers.
- *     The function requires access to the orginal tree as well in case a node
- *     needs to be deleted in the case of a failure to generate an isotopic 
+ *     The function requires access to the store as well in case a peptide
+ *     needs to be removed in the case of a failure to generate an isotopic 
  *     pattern. This function will spawn multiple threads.
  */
-PeptidePointer initIsotopicPatterns(PeptidePointer root, 
+void initIsotopicPatterns(PeptideStorePointer store,
 	PeptidePointer *peptides, int peptideCount);
 
 /*
  * printSearchResults - Print peptide sequences and all files and scans in 
  *     which the peptides where identified. For ms1 identifications print a
- *     table of including charge and correlation information.
+ *     table of including charge and correlation information, or the apex
+ *     of each file's summary when streaming.
  */
-void printSearchResults(PeptidePointer *peptides, int peptideCount);
+void printSearchResults(PeptidePointer *peptides, int peptideCount,
+	SpectraFileNodePointer filelist, struct hitStore *ms2hits,
+	struct hitStore *ms1hits);
 
 /*
  * printTable - Print a table of peptide values for every peptide, in the
  *     peptide list and every file in the filelist.
  */
 void printTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **table, char *filename);
+	int peptideCount, int fileCount, struct matrix *table, char *filename);
 
 /*
  * printPepTable - Print a table of peptide values for every peptide, in the
@@ -146,44 +174,83 @@ void printTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
  *     maps;
  */
 void printPepTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **table, char *filename,
-	char **proteinMap);
+	int peptideCount, int fileCount, struct matrix *table,
+	char *filename, char **proteinMap);
 
 /*
  * searchMzXMLs - For every mzXML file in the mzXML filelist search ms1 spectra
- *     for isotopic patterns of each peptide. Store search results within the 
- *     the corresponding peptide node.
+ *     for isotopic patterns of each peptide and fill in the retention time
+ *     and total ion current of the identified ms2 scans in ms2hits. Return
+ *     the ms1 hits of every peptide row, NULL if out of memory. first, when
+ *     not NULL, is the already read mzXML of the first file in the filelist
+ *     and is consumed; it is searched in the first wave and counted against
+ *     its memory budget.
+ */
+struct hitStore *searchMzXMLs(struct hitStore *ms2hits,
+	PeptidePointer *peptides, int peptideCount,
+	SpectraFileNodePointer filelist, struct mzxml *first);
+
+/*
+ * newFilelist - Using the array of peptides create and return the set of
+ *     files from which the peptide list was derived. Peptides are given their
+ *     position in the array as row. Files of the user's data list are
+ *     registered in the store's files.
  */
-void searchMzXMLs(PeptidePointer *peptides, int peptideCount,
-	SpectraFileNodePointer filelist);
+SpectraFileNodePointer newFilelist(PeptideStorePointer store,
+	PeptidePointer *peptides, int peptideCount);
 
 /*
  * initFilelist - Using the array of peptides create a set of files from which
  *     the peptide list was derived and return the number of files in that set.
  */
-int initFilelist(SpectraFileNodePointer *filelist, PeptidePointer *peptides,
-	int peptideCount);
+int initFilelist(SpectraFileNodePointer *filelist, PeptideStorePointer store,
+	PeptidePointer *peptides, int peptideCount);
+
+/*
+ * fileColumns - Return an array giving the position in the filelist of every
+ *     registered file id, -1 for files not in the filelist. Return NULL if
+ *     out of memory.
+ */
+int *fileColumns(struct fileRegistry *files, SpectraFileNodePointer filelist);
+
+/*
+ * psmHits - Return the identified ms2 scans of the store's peptides with a row
+ *     below rowCount in the files of the filelist as a hit store, columns
+ *     giving the filelist position of every file id. NULL if out of memory.
+ */
+struct hitStore *psmHits(PeptideStorePointer store, int *columns,
+	int rowCount);
 
 /*
- * getCount - return the number of peptides in the peptide tree
+ * getCount - return the number of peptides in the peptide store
  */
-int getCount(PeptidePointer root);
+int getCount(PeptideStorePointer store);
 
 /*
  * inOrder - allocate space for an array of peptidePointers and populate the
- *     array in order using the Peptide tree.
+ *     array with the peptides of the store sorted by sequence (strcmp).
  */
-PeptidePointer *inOrder(PeptidePointer root, int count);
+PeptidePointer *inOrder(PeptideStorePointer store, int count);
 
 /*
  * parseStatQuestdir - Given a directory path containing StatQuest results parse
  *     those results. Only supports SEQUEST searches with no mods. The cutoff
  *      represents the confidence filter used and should be part of every 
- *      statQuest fileaname.
+ *      statQuest fileaname. Identifications are added to the passed store.
  */
-PeptidePointer parseStatQuestdir(char *dirName, int cutOff);
+PeptideStorePointer parseStatQuestdir(char *dirName, int cutOff,
+	PeptideStorePointer store);
+
+PeptideStorePointer parseFuse(char *filename, PeptideStorePointer store);
 
-PeptidePointer parseFuse(char *filename, PeptidePointer pp);
+/*
+ * parseFiles - Parse the count search results files at paths with parser on
+ *     the pool, each into a store of its own, and merge those stores into
+ *     store in the order of the files. Return store.
+ */
+PeptideStorePointer parseFiles(char **paths, int count,
+	PeptideStorePointer (*parser)(char *, PeptideStorePointer),
+	PeptideStorePointer store);
 
 #endif
 
@@ -25,14 +25,14 @@
 #ifndef PEPXML_H
 #define PEPXML_H
 
-#include "peptide.h" //PeptidePointer, addPeptide
+#include "peptide.h" //PeptideStorePointer, addPeptide
 
 /*
  * parsePepXMLdir -  given the path of a directory of pepXML files parse all
  *     pepXML files and store the peptide identifications and related info
- *     in a Peptide linked list and return a pointer to the root node. 
+ *     in the passed peptide store and return it.
  */
-PeptidePointer parsePepXMLdir(char *dirName);
+PeptideStorePointer parsePepXMLdir(char *dirName, PeptideStorePointer store);
 
 #endif
 
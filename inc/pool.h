@@ -0,0 +1,89 @@
+/*
+ * pool.h                                                                    
+ * ======                                                                    
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for pool.c. A persistent pool of worker threads with          
+ *     work-stealing deques used by every multi-threaded stage.              
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h> //size_t
+
+/*
+ * PoolTask - A task run by poolFor for a single index. worker is the id of the
+ *     pool thread running it, 0 being the thread that initialized the pool.
+ */
+typedef void (*PoolTask)(void *arg, int index, int worker);
+
+/*
+ * initPool - Start threads - 1 workers. The calling thread is worker 0 and
+ *     runs tasks while it waits in poolFor. Return 0 if the pool was started,
+ *     -1 otherwise.
+ */
+int initPool(int threads);
+
+/*
+ * delPool - Stop and join the workers and free all memory allocated for the
+ *     pool.
+ */
+void delPool(void);
+
+/*
+ * poolFor - Run task(arg, i, worker) for every i in [0, count) on the pool and
+ *     return once all have finished. Indices are queued in chunks of chunk
+ *     indices, a chunk of 0 or less picks one. The calling thread runs tasks
+ *     while it waits so poolFor may be called from within a task.
+ */
+void poolFor(int count, int chunk, PoolTask task, void *arg);
+
+/*
+ * poolGraph - Run task(arg, i, worker) for count indices on the pool starting
+ *     with the readyCount indices in ready, and return once count indices have
+ *     finished. Tasks queue further indices with poolSpawn as they become
+ *     ready, so each index must be spawned exactly once.
+ */
+void poolGraph(int count, int *ready, int readyCount, PoolTask task,
+	void *arg);
+
+/*
+ * poolSpawn - Queue another index of the poolGraph batch of the running task.
+ */
+void poolSpawn(int index);
+
+/*
+ * poolWorker - Return the id of the calling pool thread, 0 for threads
+ *     outside the pool.
+ */
+int poolWorker(void);
+
+/*
+ * poolSize - Return the number of pool threads including worker 0.
+ */
+int poolSize(void);
+
+/*
+ * poolScratch - Return a scratch buffer of at least size bytes owned by the
+ *     calling pool thread, NULL if it could not be allocated. The buffer is
+ *     reused by the next call so must not be held across a nested poolFor.
+ */
+void *poolScratch(size_t size);
+
+#endif
@@ -27,6 +27,7 @@
 
 #include "fasta.h" //FastaPointer
 #include "peptide.h" //PeptidePointer
+#include "matrix.h" //MatrixPointer
 
 /*
  * proteinNode - A node for a linked list containing the ids and intensities 
@@ -47,16 +48,17 @@ typedef struct proteinNode {
  *     the linked list.
  */
 int pep2prot(ProteinNodePointer *root, FastaPointer fasta,
-	PeptidePointer *peptides, double **pepQuant, double **spectralCounts,
+	PeptidePointer *peptides, MatrixPointer pepQuant,
+	MatrixPointer spectralCounts,
 	int peptideCount, int fileCount, char ***proteinMap);
 
 /*
- * prot2table - Copy the intensities values contained in a protein list to a
- *     2D array of appropriate size.
+ * prot2table - Copy the intensities values contained in a protein list to
+ *     matrices of appropriate size.
  */
-void prot2table(ProteinNodePointer pnp, double ***protQuant,
-	double ***protHQuant, double ***protLQuant, double ***protSpectralCounts,
-	int proteinCount, int fileCount);
+void prot2table(ProteinNodePointer pnp, MatrixPointer protQuant,
+	MatrixPointer protHQuant, MatrixPointer protLQuant,
+	MatrixPointer protSpectralCounts, int proteinCount, int fileCount);
 
 /*
  * delProteinList - Free all memory allocated for the protein linked list.
@@ -69,7 +71,7 @@ ProteinNodePointer delProteinList(ProteinNodePointer pnp);
  *     the protein list and every file in the filelist.
  */
 void printProtTable(ProteinNodePointer pnp, SpectraFileNodePointer filelist,
-	int proteinCount, int fileCount, double **table, char *filename);
+	int proteinCount, int fileCount, MatrixPointer table, char *filename);
 
 /*
  * delProteinMap - Free all memory allocated for the proteinMap.
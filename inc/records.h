@@ -0,0 +1,110 @@
+/*
+ * records.h                                                                 
+ * =========                                                                 
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for records.c. Contains the memory mapped reader of delimited 
+ *     text files: records are found without copying the file and their      
+ *     fields are located by header name.                                    
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <stdbool.h>
+#include <stddef.h> //size_t
+
+/*
+ * records - A delimited text file mapped read only into memory. Records are
+ *     its lines, without the line ending.
+ */
+typedef struct records {
+	const char *data; //NULL if the file is empty
+	size_t size;
+} Records, *RecordsPointer;
+
+/*
+ * field - A field of a record. Points into the mapped file so is not NUL
+ *     terminated.
+ */
+typedef struct field {
+	const char *start;
+	int length;
+} Field, *FieldPointer;
+
+/*
+ * newRecords - Map the file filename. Return NULL if it could not be opened
+ *     or mapped.
+ */
+RecordsPointer newRecords(char *filename);
+
+/*
+ * delRecords - Unmap the file and free the records. Return NULL.
+ */
+RecordsPointer delRecords(RecordsPointer rp);
+
+/*
+ * nextRecord - Return the record starting at *cursor and set *length to its
+ *     length without the line ending. *cursor is moved to the next record.
+ *     Return NULL once *cursor reaches end.
+ */
+const char *nextRecord(const char **cursor, const char *end, int *length);
+
+/*
+ * splitRecord - Locate up to max fields of record separated by delim and
+ *     return how many were found. With collapse, runs of delim separate a
+ *     single pair of fields and leading ones are skipped, as with strtok.
+ */
+int splitRecord(const char *record, int length, char delim, bool collapse,
+	FieldPointer fields, int max);
+
+/*
+ * findColumn - Return the index of the field named name among the count
+ *     header fields, fallback if there is none.
+ */
+int findColumn(FieldPointer header, int count, const char *name,
+	int fallback);
+
+/*
+ * chunkRecords - Split the records from offset on into chunks of about
+ *     chunkSize bytes, each starting at a record. Set *bounds to the
+ *     chunkCount+1 offsets the chunks start and end at and return chunkCount.
+ *     Exits if out of memory.
+ */
+int chunkRecords(RecordsPointer rp, size_t offset, size_t chunkSize,
+	size_t **bounds);
+
+/*
+ * fieldIs - Return true if the field reads exactly text.
+ */
+bool fieldIs(FieldPointer field, const char *text);
+
+/*
+ * fieldInt - Return the integer at the start of the field, as atoi would.
+ */
+int fieldInt(FieldPointer field);
+
+/*
+ * fieldString - Copy the field followed by suffix, which may be NULL, into
+ *     *buffer as a string and return it. *buffer holds *size bytes and is
+ *     grown as needed. Exits if out of memory.
+ */
+char *fieldString(FieldPointer field, const char *suffix, char **buffer,
+	int *size);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * registry.h                                                                
+ * ==========                                                                
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for registry.c. Contains the definition of the registry that  
+ *     gives every spectra file a dense integer id so that per file lookups  
+ *     are array indexing rather than string comparison.                     
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdint.h> //uint32_t
+
+/*
+ * nameTable - Open addressing hash table from strings to ints. Keys are not
+ *     owned by the table.
+ */
+typedef struct nameTable {
+	const char **keys; //NULL where empty
+	uint32_t *hashes;
+	int *values;
+	int size; //a power of two
+	int count;
+} NameTable, *NameTablePointer;
+
+/*
+ * fileRegistry - The spectra files known to a run. Ids are handed out in the
+ *     order files are first seen and index names. Names given by the search
+ *     results are resolved against the user's data list, if any, once and
+ *     remembered.
+ */
+typedef struct fileRegistry {
+	char **names; //interned names by id
+	int count;
+	int capacity;
+	NameTable ids; //interned name to id
+	NameTable resolved; //search result name to id, -1 if not in the data list
+	NameTable basenames; //data list basename to data list index
+	struct arena *strings; //owns the names and resolved keys
+} FileRegistry, *FileRegistryPointer;
+
+/*
+ * newFileRegistry - Allocate an empty registry, indexing the basenames of the
+ *     data list if there is one. Return NULL if out of memory.
+ */
+FileRegistryPointer newFileRegistry(void);
+
+/*
+ * delFileRegistry - Free all memory allocated for the registry. Return NULL.
+ */
+FileRegistryPointer delFileRegistry(FileRegistryPointer fr);
+
+/*
+ * internFile - Return the id of the file name, registering it if it is new.
+ */
+int internFile(FileRegistryPointer fr, const char *name);
+
+/*
+ * resolveFile - Return the id of the file a search result names. With a data
+ *     list this is the first data list file whose path contains the name, or
+ *     -1 if none does, otherwise the name itself.
+ */
+int resolveFile(FileRegistryPointer fr, const char *name);
+
+/*
+ * fileName - Return the interned name of the file id.
+ */
+char *fileName(FileRegistryPointer fr, int id);
+
+#endif
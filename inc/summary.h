@@ -0,0 +1,94 @@
+/*
+ * summary.h                                                                 
+ * =========                                                                 
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for summary.c. Contains the definition of a fixed size        
+ *     summary of the ms1 hits of a peptide in a single LC-MS run and        
+ *     functions for folding hits into it and reading it back.               
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#define SUMMARY_BINS 32 //retention time bins kept per peptide and file
+
+struct hitBuffer;
+struct mzxml;
+
+/*
+ * ms1Summary - The ms1 hits of a peptide in a single LC-MS run folded into
+ *     the apex hit, whether another hit lies within peakWindow of the apex,
+ *     the intensity of hits within quantWindow of the apex and of the
+ *     anchor, and the intensity of hits binned over 2*quantWindow either
+ *     side of the apex for windows about any other retention time.
+ */
+typedef struct ms1Summary {
+	int hits;
+	int neighbour;
+	int anchored;
+	float apexRT;
+	double apexIntensity;
+	double apexWindow; //intensity within quantWindow of apexRT
+	double anchorRT; //ms2 centroid of the peptide in the run, if anchored
+	double anchorWindow; //intensity within quantWindow of anchorRT
+	double binStart; //retention time the first bin starts at
+	float bins[SUMMARY_BINS];
+} Ms1Summary, *Ms1SummaryPointer;
+
+/*
+ * newMs1Summaries - Allocate and clear one summary per file. Return a pointer
+ *     to the first summary, NULL if an error occured.
+ */
+Ms1SummaryPointer newMs1Summaries(int fileCount);
+
+/*
+ * delMs1Summaries - Free all memory allocated for the summaries.
+ */
+Ms1SummaryPointer delMs1Summaries(Ms1SummaryPointer ms);
+
+/*
+ * anchorSummary - Also keep the intensity within quantWindow of the retention
+ *     time rt exactly. Must be called before the hits are summarised.
+ */
+void anchorSummary(Ms1SummaryPointer ms, double rt);
+
+/*
+ * summariseHits - Fold every hit of the peptide in the run, buffered with
+ *     width intensities and correlations each, into the summary. Retention
+ *     times are those of the hits' scans in mzXML.
+ */
+void summariseHits(Ms1SummaryPointer ms, struct hitBuffer *hb, int width,
+	struct mzxml *mzXML);
+
+/*
+ * summaryApexRT - Return the retention time of the most intense hit, 0 if
+ *     there is no other hit within peakWindow of it.
+ */
+double summaryApexRT(Ms1SummaryPointer ms);
+
+/*
+ * summaryIntensity - Return the intensity of valid hits within quantWindow of
+ *     the retention time centre. Windows about the apex or the anchor are
+ *     exact. Others are summed from the bins, splitting bins partly inside the
+ *     window by their overlap and missing hits more than 2*quantWindow from
+ *     the apex.
+ */
+double summaryIntensity(Ms1SummaryPointer ms, double centre);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * xic.h                                                                     
+ * =====                                                                     
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Header file for xic.c. Contains the definition of a per-file store of ms1 
+ *     peaks in retention time order, and functions for extracting ion       
+ *     chromatograms (XICs) from the store.                                  
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#ifndef XIC_H
+#define XIC_H
+
+#include "mzXML.h" //MZXMLPointer
+
+struct calibration;
+
+/*
+ * xicStore - The ms1 scans of a single LC-MS run held in contiguous arrays.
+ *     Peaks of scan i occupy [offset[i], offset[i+1]) of the mz and intensity
+ *     arrays and scans are stored in order of increasing retention time.
+ */
+typedef struct xicStore {
+	int scanCount;
+	int *scanNum;
+	float *rt;
+	int *offset;
+	float *mz;
+	float *intensity;
+} XicStore, *XicStorePointer;
+
+/*
+ * newXicStore - Copy the ms1 peak lists of the mzXML into a new XicStore.
+ *     Return a pointer to the new store, NULL if an error occured.
+ */
+XicStorePointer newXicStore(MZXMLPointer mzXML);
+
+/*
+ * delXicStore - Free all memory allocated for the XicStore.
+ */
+XicStorePointer delXicStore(XicStorePointer xs);
+
+/*
+ * peakIntensity - Search a peak list for the mz within tolerance (relative)
+ *     and return the summed intensity of the peak closest to it, 0 if there
+ *     is none.
+ */
+float peakIntensity(float mz, float *mzList, float *intList, int peaksCount,
+	double tolerance);
+
+/*
+ * peakApex - Search a peak list for the mz within tolerance (relative) and
+ *     return the mz of the most intense point within tolerance, 0 if none of
+ *     them hold intensity.
+ */
+float peakApex(float mz, float *mzList, float *intList, int peaksCount,
+	double tolerance);
+
+/*
+ * xicTrace - Extract the chromatogram of the mz over scans [first, last) of
+ *     the store. The mz is corrected and searched with the tolerance of the
+ *     calibration of each scan, or searched within ppmCutOff if cal is NULL.
+ *     Traces are indexed from the first scan, trace[i - first] holds the
+ *     intensity found in scan i.
+ */
+void xicTrace(XicStorePointer xs, float mz, int first, int last,
+	struct calibration *cal, float *trace);
+
+#endif
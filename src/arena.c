@@ -0,0 +1,124 @@
+/*
+ * arena.c                                                                   
+ * =======                                                                   
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for allocating many small objects that share a lifetime by      
+ *     bumping a pointer through large blocks, and releasing them all at     
+ *     once by freeing the blocks.                                           
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "arena.h"
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, free
+#include <string.h> //strlen, memcpy
+
+/*
+ * newBlock - Allocate a block holding at least size bytes of data. Return
+ *     NULL if out of memory.
+ */
+ArenaBlockPointer newBlock(size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+ArenaPointer newArena(size_t blockSize){
+	ArenaPointer ap = (ArenaPointer)malloc(sizeof(Arena));
+	if(ap == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create arena!\n");
+		return NULL;
+	}
+	ap->blocks = NULL;
+	ap->blockSize = blockSize > 0? blockSize : ARENA_BLOCK;
+	return ap;
+}
+
+
+ArenaPointer delArena(ArenaPointer ap){
+	if(ap == NULL){
+		return NULL;
+	}
+	while(ap->blocks != NULL){
+		ArenaBlockPointer next = ap->blocks->next;
+		free(ap->blocks);
+		ap->blocks = next;
+	}
+	free(ap);
+	ap = NULL;
+	return ap;
+}
+
+
+ArenaBlockPointer newBlock(size_t size){
+	ArenaBlockPointer bp = (ArenaBlockPointer)malloc(sizeof(ArenaBlock) +
+		size);
+	if(bp == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot grow arena!\n");
+		return NULL;
+	}
+	bp->next = NULL;
+	bp->used = 0;
+	bp->size = size;
+	return bp;
+}
+
+
+void *arenaAlloc(ArenaPointer ap, size_t size){
+	if(ap == NULL){
+		return malloc(size);
+	}
+
+	/*keep every allocation aligned as its block's data is*/
+	size = (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+	ArenaBlockPointer bp = ap->blocks;
+	if(bp == NULL || bp->size - bp->used < size){
+		/*large requests get a block of their own behind the current one so
+		its remaining space is not wasted*/
+		if(bp != NULL && size > ap->blockSize / 4){
+			ArenaBlockPointer large = newBlock(size);
+			if(large == NULL){
+				return NULL;
+			}
+			large->used = size;
+			large->next = bp->next;
+			bp->next = large;
+			return large->data;
+		}
+		bp = newBlock(size > ap->blockSize? size : ap->blockSize);
+		if(bp == NULL){
+			return NULL;
+		}
+		bp->next = ap->blocks;
+		ap->blocks = bp;
+	}
+	void *p = (char *)bp->data + bp->used;
+	bp->used += size;
+	return p;
+}
+
+
+char *arenaString(ArenaPointer ap, const char *string){
+	size_t length = strlen(string) + 1;
+	char *copy = (char *)arenaAlloc(ap, length);
+	if(copy != NULL){
+		memcpy(copy, string, length);
+	}
+	return copy;
+}
@@ -0,0 +1,334 @@
+/*
+ * calibrate.c                                                               
+ * ===========                                                               
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for fitting a per-file m/z calibration to the precursors of     
+ *     identified ms2 scans and applying it to theoretical m/z values.       
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "calibrate.h"
+#include "common.h" //MIN_CHARGE, selectRank
+#include "global.h" //ppmCutOff, maxCharge
+#include "isotope.h" //PROTON
+#include "xic.h" //peakApex
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, free
+#include <math.h> //fabs
+
+#define CAL_MIN_POINTS 5 //fewest precursors to calibrate with
+#define CAL_FIT_POINTS 30 //fewest precursors to fit rt and mz terms with
+#define CAL_MIN_TOLERANCE 0.000002 //tightest tolerance searched with
+#define MAD_SCALE 1.4826 //scales a MAD to a normal standard deviation
+
+/*
+ * calibrationPoint - The relative m/z error of a precursor observed in ms1.
+ */
+typedef struct calibrationPoint {
+	double rt;
+	double mz;
+	double error;
+} CalibrationPoint, *CalibrationPointPointer;
+
+/*
+ * collectPoints - Measure the m/z error of every identified precursor of the
+ *     mzXML in the ms1 scan preceding its ms2 scan. Return the points and
+ *     store their number in count.
+ */
+CalibrationPointPointer collectPoints(MZXMLPointer mzXML,
+	HitStorePointer ms2hits, int column, PeptidePointer *peptides,
+	int peptideCount, int *count);
+
+/*
+ * fitCalibration - Fit the calibration to the points, discarding points
+ *     further than 3 standard deviations from the median error first.
+ */
+void fitCalibration(CalibrationPointer cal, CalibrationPointPointer points,
+	int count);
+
+/*
+ * solve3 - Solve the 3x3 linear system a*x = b by Gaussian elimination with
+ *     partial pivoting. Return 0 if the system is singular, 1 otherwise.
+ */
+int solve3(double a[3][3], double b[3], double x[3]);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+CalibrationPointer newCalibration(MZXMLPointer mzXML, HitStorePointer ms2hits,
+	int column, PeptidePointer *peptides, int peptideCount){
+	int count;
+	CalibrationPointPointer points = collectPoints(mzXML, ms2hits, column,
+		peptides, peptideCount, &count);
+	if(points == NULL){
+		return NULL;
+	}
+	if(count < CAL_MIN_POINTS){
+		printf("\tOnly %d precursors found, not recalibrating\n", count);
+		free(points);
+		return NULL;
+	}
+
+	CalibrationPointer cal = (CalibrationPointer)malloc(sizeof(Calibration));
+	if(cal == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot recalibrate!\n");
+		free(points);
+		return NULL;
+	}
+	fitCalibration(cal, points, count);
+	free(points);
+	if(cal->points < CAL_MIN_POINTS){
+		printf("\tOnly %d precursors found, not recalibrating\n", cal->points);
+		return delCalibration(cal);
+	}
+	printf("\tCalibrated with %d precursors: shift %.2f ppm, tolerance %.2f "
+		"ppm\n", cal->points, cal->intercept*1E6, cal->tolerance*1E6);
+	return cal;
+}
+
+
+CalibrationPointer delCalibration(CalibrationPointer cal){
+	free(cal);
+	cal = NULL;
+	return cal;
+}
+
+
+float calibrateMz(CalibrationPointer cal, float mz, float rt){
+	if(cal == NULL){
+		return mz;
+	}
+	double error = cal->intercept + cal->rtSlope*(rt - cal->rtMean) +
+		cal->mzSlope*(mz - cal->mzMean);
+	return mz * (1 + error);
+}
+
+
+double calibratedTolerance(CalibrationPointer cal){
+	return cal == NULL ? ppmCutOff : cal->tolerance;
+}
+
+
+CalibrationPointPointer collectPoints(MZXMLPointer mzXML,
+	HitStorePointer ms2hits, int column, PeptidePointer *peptides,
+	int peptideCount, int *count){
+	int i, h;
+	int size = 0;
+	*count = 0;
+
+	/*count identified ms2 scans of this file*/
+	for(i = 0; i < peptideCount; ++i){
+		int run = findRun(ms2hits, peptides[i]->row, column);
+		if(run >= 0){
+			size += ms2hits->hitStart[run+1] - ms2hits->hitStart[run];
+		}
+	}
+
+	CalibrationPointPointer points = (CalibrationPointPointer)malloc(
+		(size ? size : 1) * sizeof(CalibrationPoint));
+	if(points == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot recalibrate!\n");
+		return NULL;
+	}
+
+	for(i = 0; i < peptideCount; ++i){
+		int run = findRun(ms2hits, peptides[i]->row, column);
+		if(run < 0){
+			continue;
+		}
+		for(h = ms2hits->hitStart[run]; h < ms2hits->hitStart[run+1]; ++h){
+			int k = ms2hits->scanNum[h] - 1;
+			if(k < 0 || k >= mzXML->scanCount){
+				continue;
+			}
+			int z = mzXML->scans[k]->precCharge;
+			if(z < MIN_CHARGE || z > maxCharge){
+				continue;
+			}
+
+			/*find the ms1 scan the precursor was selected from*/
+			while(k >= 0 && mzXML->scans[k]->msLevel != 1){
+				--k;
+			}
+			if(k < 0 || mzXML->scans[k]->peaksCount < MIN_PEAK_COUNT ||
+				mzXML->scans[k]->mzList == NULL){
+				continue;
+			}
+			ScanPointer sp = mzXML->scans[k];
+
+			/*measure the most intense isotope*/
+			float mz = (peptides[i]->ip->mass[0] + PROTON*z)/z;
+			float observed = peakApex(mz, sp->mzList, sp->intList,
+				sp->peaksCount, ppmCutOff);
+			if(observed > 0){
+				points[*count].rt = sp->retentionTime;
+				points[*count].mz = mz;
+				points[*count].error = ((double)observed - mz)/mz;
+				(*count)++;
+			}
+		}
+	}
+	return points;
+}
+
+
+void fitCalibration(CalibrationPointer cal, CalibrationPointPointer points,
+	int count){
+	int i, j, k;
+	double *values = (double *)malloc(count * sizeof(double));
+	if(values == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot recalibrate!\n");
+		cal->points = 0;
+		return;
+	}
+
+	/*discard outliers using the median absolute deviation*/
+	for(i = 0; i < count; ++i){
+		values[i] = points[i].error;
+	}
+	double median = count%2 ? selectRank(values, count, count/2) :
+		( (selectRank(values, count, count/2 - 1) +
+			selectRank(values, count, count/2)) / 2);
+	for(i = 0; i < count; ++i){
+		values[i] = fabs(points[i].error - median);
+	}
+	double limit = 3 * MAD_SCALE * (count%2 ?
+		selectRank(values, count, count/2) :
+		( (selectRank(values, count, count/2 - 1) +
+			selectRank(values, count, count/2)) / 2) );
+	int kept = 0;
+	for(i = 0; i < count; ++i){
+		if(fabs(points[i].error - median) <= limit){
+			points[kept++] = points[i];
+		}
+	}
+
+	cal->intercept = median;
+	cal->rtSlope = 0;
+	cal->mzSlope = 0;
+	cal->rtMean = 0;
+	cal->mzMean = 0;
+	cal->points = kept;
+
+	/*fit error = intercept + rtSlope*rt + mzSlope*mz on centred values*/
+	if(kept >= CAL_FIT_POINTS){
+		for(i = 0; i < kept; ++i){
+			cal->rtMean += points[i].rt;
+			cal->mzMean += points[i].mz;
+		}
+		cal->rtMean /= kept;
+		cal->mzMean /= kept;
+
+		double a[3][3] = {{0}};
+		double b[3] = {0};
+		double x[3];
+		for(i = 0; i < kept; ++i){
+			double row[3] = {1, points[i].rt - cal->rtMean,
+				points[i].mz - cal->mzMean};
+			for(j = 0; j < 3; ++j){
+				for(k = 0; k < 3; ++k){
+					a[j][k] += row[j]*row[k];
+				}
+				b[j] += row[j]*points[i].error;
+			}
+		}
+		if(solve3(a, b, x)){
+			cal->intercept = x[0];
+			cal->rtSlope = x[1];
+			cal->mzSlope = x[2];
+		}else{
+			cal->rtMean = 0;
+			cal->mzMean = 0;
+		}
+	}
+
+	/*search within 3 standard deviations of the corrected error*/
+	for(i = 0; i < kept; ++i){
+		values[i] = points[i].error - (cal->intercept +
+			cal->rtSlope*(points[i].rt - cal->rtMean) +
+			cal->mzSlope*(points[i].mz - cal->mzMean));
+	}
+	median = 0;
+	if(kept){
+		median = kept%2 ? selectRank(values, kept, kept/2) :
+			( (selectRank(values, kept, kept/2 - 1) +
+				selectRank(values, kept, kept/2)) / 2);
+	}
+	for(i = 0; i < kept; ++i){
+		values[i] = fabs(values[i] - median);
+	}
+	cal->tolerance = ppmCutOff;
+	if(kept){
+		cal->tolerance = 3 * MAD_SCALE * (kept%2 ?
+			selectRank(values, kept, kept/2) :
+			( (selectRank(values, kept, kept/2 - 1) +
+				selectRank(values, kept, kept/2)) / 2) );
+	}
+	if(cal->tolerance < CAL_MIN_TOLERANCE){
+		cal->tolerance = CAL_MIN_TOLERANCE;
+	}
+	if(cal->tolerance > ppmCutOff){
+		cal->tolerance = ppmCutOff;
+	}
+	free(values);
+	return;
+}
+
+
+int solve3(double a[3][3], double b[3], double x[3]){
+	int i, j, k;
+	for(i = 0; i < 3; ++i){
+		/*pivot on the largest remaining value of the column*/
+		int pivot = i;
+		for(j = i + 1; j < 3; ++j){
+			if(fabs(a[j][i]) > fabs(a[pivot][i])){
+				pivot = j;
+			}
+		}
+		if(fabs(a[pivot][i]) < 1E-12){
+			return 0;
+		}
+		for(k = 0; k < 3; ++k){
+			double tmp = a[i][k];
+			a[i][k] = a[pivot][k];
+			a[pivot][k] = tmp;
+		}
+		double tmp = b[i];
+		b[i] = b[pivot];
+		b[pivot] = tmp;
+
+		for(j = i + 1; j < 3; ++j){
+			double factor = a[j][i]/a[i][i];
+			for(k = i; k < 3; ++k){
+				a[j][k] -= factor*a[i][k];
+			}
+			b[j] -= factor*b[i];
+		}
+	}
+	for(i = 2; i >= 0; --i){
+		x[i] = b[i];
+		for(k = i + 1; k < 3; ++k){
+			x[i] -= a[i][k]*x[k];
+		}
+		x[i] /= a[i][i];
+	}
+	return 1;
+}
+
@@ -23,49 +23,115 @@
 
 #include "common.h"
 #include "global.h"
+#include "pool.h" //poolScratch
 
-#include <stdlib.h> //qsort, malloc, free
-#include <string.h> //memcpy
+#include <stdlib.h> //malloc, free
+#include <string.h> //strspn, strcspn
 #include <math.h> //fabs, fmax
 #include <stdio.h>
+#include <stdbool.h>
 
 int comparedouble (const void * a, const void * b){
-	return ( *(double*)b - *(double*)a );
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+
+double selectRank(double *values, int count, int rank){
+	int lo = 0;
+	int hi = count - 1;
+	while(lo < hi){
+		/*median of three pivot keeps ordered rows from going quadratic*/
+		int mid = lo + (hi - lo) / 2;
+		double a = values[lo];
+		double b = values[mid];
+		double c = values[hi];
+		double pivot = (a < b) ? ( (b < c) ? b : ( (a < c) ? c : a) ) :
+			( (a < c) ? a : ( (b < c) ? c : b) );
+		int i = lo;
+		int j = hi;
+		while(i <= j){
+			while(values[i] < pivot){
+				++i;
+			}
+			while(values[j] > pivot){
+				--j;
+			}
+			if(i <= j){
+				double swap = values[i];
+				values[i++] = values[j];
+				values[j--] = swap;
+			}
+		}
+		/*values between j and i all equal the pivot*/
+		if(rank <= j){
+			hi = j;
+		}else if(rank >= i){
+			lo = i;
+		}else{
+			break;
+		}
+	}
+	return values[rank];
 }
 
 
 double median(double *list, int size){
-	
-	/*make a copy and sort copy in place*/
-	double copyList[size];
-	memcpy(copyList, list, size*sizeof(double));
-	qsort(copyList, size, sizeof(double), comparedouble); 
-	
+	int i;
+
 	/*remove zeroes if list does not contain negative values*/
-	while(size > 0 && copyList[size-1] == 0){
-		size--;
+	bool negative = false;
+	for(i = 0; i < size; ++i){
+		if(list[i] < 0){
+			negative = true;
+		}
 	}
 
-	/* want at least three non-zero entries to take median */
-	if (size < 3) return 0;
-
-	/* IQR should be reasonable */
-	double third_quartile = (size/2)%2 ?
-			(copyList[size/4]) :
-			( (copyList[size/4-1] + copyList[size/4]) / 2);
-	double first_quartile = (size/2)%2 ?
-				(copyList[3*size/4]) :
-				( (copyList[3*size/4-1] + copyList[3*size/4]) / 2);
-	double iqr = third_quartile - first_quartile;
-	if(iqr > 250) {
-		return 0;
+	/*select from a copy, kept in the worker's scratch when on the pool*/
+	bool owned = false;
+	double *values = (double *)poolScratch(size * sizeof(double));
+	if(values == NULL){
+		values = (double *)malloc( (size ? size : 1) * sizeof(double));
+		owned = true;
+		if(values == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot take median!\n");
+			exit(1);
+		}
+	}
+	int n = 0;
+	for(i = 0; i < size; ++i){
+		if(negative || list[i] != 0){
+			values[n++] = list[i];
+		}
 	}
 
-	if(size%2){
-		return (copyList[size/2]);
-	}else{
-		return ( (copyList[size/2-1] + copyList[size/2]) / 2 );
+	/* want at least three non-zero entries to take median */
+	double result = 0;
+	if(n >= 3){
+		/*quartiles are taken counting down from the largest value*/
+		int top = n - 1;
+		double third_quartile = (n/2)%2 ?
+			selectRank(values, n, top - n/4) :
+			( (selectRank(values, n, top - (n/4-1)) +
+				selectRank(values, n, top - n/4)) / 2);
+		double first_quartile = (n/2)%2 ?
+			selectRank(values, n, top - 3*n/4) :
+			( (selectRank(values, n, top - (3*n/4-1)) +
+				selectRank(values, n, top - 3*n/4)) / 2);
+
+		/* IQR should be reasonable */
+		double iqr = third_quartile - first_quartile;
+		if(iqr <= 250){
+			result = n%2 ? selectRank(values, n, top - n/2) :
+				( (selectRank(values, n, top - (n/2-1)) +
+					selectRank(values, n, top - n/2)) / 2 );
+		}
 	}
+	if(owned){
+		free(values);
+	}
+	return result;
 }
 
 
@@ -103,23 +169,22 @@ float pearson(float *y, float *foundPattern, float *corr){
 }
 
 
-double **new2Darray(int x, int y){
-	double **array = (double **)malloc(x * sizeof(double*));
-	int i;
-	for(i = 0; i < x; ++i){
-		array[i] = (double *)malloc(y * sizeof(double));
+char *nextToken(char **cursor, const char *delim){
+	char *token = *cursor;
+	if(token == NULL){
+		return NULL;
 	}
-	return array;
-}
-
-
-double **del2Darray(double **array, int x){
-	int i;
-	for(i = 0; i < x; ++i){
-		free(array[i]);
+	token += strspn(token, delim);
+	if(*token == '\0'){
+		*cursor = NULL;
+		return NULL;
 	}
-	free(array);
-	array = NULL;
-	return array;
+	char *end = token + strcspn(token, delim);
+	if(*end == '\0'){
+		*cursor = NULL;
+	}else{
+		*end = '\0';
+		*cursor = end + 1;
+	}
+	return token;
 }
-
@@ -24,6 +24,7 @@
  */
 
 #include "fasta.h"
+#include "common.h" //nextToken
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -232,8 +233,9 @@ int readFASTA(char *filename, FastaPointer *fasta ){
 
 	(*fasta) = newFasta();
 
-	char *tokens;
-	tokens = strtok(filename, "+");
+	/*strtok is not reentrant and parsing may run alongside*/
+	char *cursor = filename;
+	char *tokens = nextToken(&cursor, "+");
 
 	while (tokens != NULL) {
 
@@ -272,7 +274,7 @@ int readFASTA(char *filename, FastaPointer *fasta ){
 		}
 
 		fclose(fp);
-		tokens = strtok(NULL, "+");
+		tokens = nextToken(&cursor, "+");
 	}
 
 	trimFastaDB((*fasta));
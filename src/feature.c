@@ -0,0 +1,407 @@
+/*
+ * feature.c                                                                 
+ * =========                                                                 
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for detecting isotope clusters in the ms1 scans of a single     
+ *     LC-MS run, linking them into features and matching peptides to them.  
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "feature.h"
+#include "common.h" //MIN_CHARGE
+#include "global.h" //ppmCutOff, intCutOff, maxCharge, isotopicStates
+#include "isotope.h" //PROTON
+
+#include <stdio.h> //fprintf, fopen, fread, fwrite
+#include <stdlib.h> //malloc, realloc, free, qsort
+#include <string.h> //strlen, strcpy, strcat, memcpy, memcmp, memset
+#include <sys/stat.h> //stat
+
+#define C13_SPACING 1.0033548378 //mass difference between 13C and 12C
+#define FEATURE_GAP 2 //store scans a feature may be missing from
+#define FEATURE_EXT ".features"
+#define FEATURE_MAGIC "PQF1"
+
+/*
+ * cluster - An isotope cluster found in a single store scan.
+ */
+typedef struct cluster {
+	float mz;
+	float intensity;
+	int charge;
+	int scan;
+} Cluster, *ClusterPointer;
+
+/*
+ * featureCache - Header of a feature cache file. A cache is only used if it
+ *     was written with the same search parameters for the same store.
+ */
+typedef struct featureCache {
+	char magic[4];
+	int maxCharge;
+	int isotopicStates;
+	int scanCount;
+	double ppmCutOff;
+	double intCutOff;
+	int count;
+} FeatureCache;
+
+/*
+ * detectClusters - Find every isotope cluster of isotopicStates peaks spaced
+ *     C13_SPACING/charge apart starting at a local intensity maximum of a
+ *     store scan. Return the clusters and store their number in count.
+ */
+ClusterPointer detectClusters(XicStorePointer xs, int *count);
+
+/*
+ * linkClusters - Link clusters of the same charge and mz found in store scans
+ *     no more than FEATURE_GAP scans apart into features. Clusters are sorted
+ *     in place.
+ */
+FeatureListPointer linkClusters(XicStorePointer xs, ClusterPointer clusters,
+	int count);
+
+/*
+ * readFeatureCache - Read the features cached at path if the cache is newer
+ *     than the file and matches the store and search parameters. Return NULL
+ *     if there is no usable cache.
+ */
+FeatureListPointer readFeatureCache(XicStorePointer xs, char *filename,
+	char *path);
+
+/*
+ * writeFeatureCache - Cache the feature list at path.
+ */
+void writeFeatureCache(XicStorePointer xs, FeatureListPointer fl, char *path);
+
+/*
+ * compareCluster - Order clusters by charge, mz and then scan.
+ */
+int compareCluster(const void *a, const void *b);
+
+/*
+ * compareClusterScan - Order clusters by scan.
+ */
+int compareClusterScan(const void *a, const void *b);
+
+/*
+ * compareFeature - Order features by mass.
+ */
+int compareFeature(const void *a, const void *b);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+FeatureListPointer findFeatures(XicStorePointer xs, char *filename){
+	if(xs == NULL){
+		return NULL;
+	}
+
+	char *path = (char *)malloc(strlen(filename) + strlen(FEATURE_EXT) + 1);
+	if(path == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot find features!\n");
+		return NULL;
+	}
+	strcpy(path, filename);
+	strcat(path, FEATURE_EXT);
+
+	FeatureListPointer fl = readFeatureCache(xs, filename, path);
+	if(fl != NULL){
+		printf("\tRead %d features from %s\n", fl->count, path);
+		free(path);
+		return fl;
+	}
+
+	int count;
+	ClusterPointer clusters = detectClusters(xs, &count);
+	if(clusters == NULL && count){
+		free(path);
+		return NULL;
+	}
+	fl = linkClusters(xs, clusters, count);
+	free(clusters);
+	if(fl != NULL){
+		printf("\tFound %d features in %d clusters\n", fl->count, count);
+		writeFeatureCache(xs, fl, path);
+	}
+	free(path);
+	return fl;
+}
+
+
+FeatureListPointer delFeatureList(FeatureListPointer fl){
+	if(fl == NULL){
+		return NULL;
+	}
+	free(fl->features);
+	free(fl);
+	fl = NULL;
+	return fl;
+}
+
+
+void featureRange(FeatureListPointer fl, double mass, double tolerance,
+	int *first, int *last){
+	double massLow = mass * (1 - tolerance);
+	double massHigh = mass * (1 + tolerance);
+
+	/*lower bound of massLow*/
+	int low = 0;
+	int high = fl->count;
+	while(low < high){
+		int mid = low + (high - low)/2;
+		if(fl->features[mid].mass < massLow){
+			low = mid + 1;
+		}else{
+			high = mid;
+		}
+	}
+	*first = low;
+
+	/*upper bound of massHigh*/
+	high = fl->count;
+	while(low < high){
+		int mid = low + (high - low)/2;
+		if(fl->features[mid].mass <= massHigh){
+			low = mid + 1;
+		}else{
+			high = mid;
+		}
+	}
+	*last = low;
+	return;
+}
+
+
+ClusterPointer detectClusters(XicStorePointer xs, int *count){
+	int size = 1024;
+	ClusterPointer clusters = (ClusterPointer)malloc(size * sizeof(Cluster));
+	*count = 0;
+	if(clusters == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot detect clusters!\n");
+		return NULL;
+	}
+
+	int i, p, z, k;
+	for(i = 0; i < xs->scanCount; ++i){
+		float *mz = xs->mz + xs->offset[i];
+		float *intensity = xs->intensity + xs->offset[i];
+		int peaksCount = xs->offset[i+1] - xs->offset[i];
+
+		for(p = 1; p < peaksCount - 1; ++p){
+			/*clusters start at the apex of a peak*/
+			if(intensity[p] <= 0 || intensity[p] < intensity[p-1] ||
+				intensity[p] <= intensity[p+1]){
+				continue;
+			}
+			for(z = MIN_CHARGE; z <= maxCharge; ++z){
+				float total = 0;
+				for(k = 0; k < isotopicStates; ++k){
+					float found = peakIntensity(mz[p] + k*C13_SPACING/z, mz,
+						intensity, peaksCount, ppmCutOff);
+					if(found <= 0){
+						break;
+					}
+					total += found;
+				}
+				/*the search requires every isotope of a charge to be found
+				and their sum to pass intCutOff*/
+				if(k < isotopicStates || total < intCutOff){
+					continue;
+				}
+				if(*count == size){
+					size *= 2;
+					ClusterPointer tmp = (ClusterPointer)realloc(clusters,
+						size * sizeof(Cluster));
+					if(tmp == NULL){
+						fprintf(stderr,
+							"\nERROR: Out of memory - cannot detect clusters!\n");
+						free(clusters);
+						return NULL;
+					}
+					clusters = tmp;
+				}
+				clusters[*count].mz = mz[p];
+				clusters[*count].intensity = total;
+				clusters[*count].charge = z;
+				clusters[*count].scan = i;
+				(*count)++;
+			}
+		}
+	}
+	return clusters;
+}
+
+
+FeatureListPointer linkClusters(XicStorePointer xs, ClusterPointer clusters,
+	int count){
+	FeatureListPointer fl = (FeatureListPointer)malloc(sizeof(FeatureList));
+	if(fl == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot link clusters!\n");
+		return NULL;
+	}
+	fl->count = 0;
+	/*every feature holds at least one cluster*/
+	fl->features = (FeaturePointer)malloc( (count ? count : 1) *
+		sizeof(Feature));
+	if(fl->features == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot link clusters!\n");
+		free(fl);
+		return NULL;
+	}
+
+	qsort(clusters, count, sizeof(Cluster), compareCluster);
+
+	int i = 0;
+	while(i < count){
+		/*group clusters of a charge whose mz are within ppmCutOff*/
+		int j = i + 1;
+		while(j < count && clusters[j].charge == clusters[i].charge &&
+			(clusters[j].mz - clusters[i].mz) / clusters[i].mz < ppmCutOff){
+			j++;
+		}
+		qsort(clusters + i, j - i, sizeof(Cluster), compareClusterScan);
+
+		/*split the group into features wherever it is missing from too many
+		scans*/
+		int k;
+		FeaturePointer fp = NULL;
+		for(k = i; k < j; ++k){
+			if(fp == NULL || clusters[k].scan - fp->last > FEATURE_GAP){
+				fp = fl->features + fl->count++;
+				fp->charge = clusters[k].charge;
+				fp->first = clusters[k].scan;
+				fp->apexIntensity = 0;
+			}
+			fp->last = clusters[k].scan;
+			if(clusters[k].intensity > fp->apexIntensity){
+				fp->apexIntensity = clusters[k].intensity;
+				fp->apex = clusters[k].scan;
+				fp->apexRT = xs->rt[clusters[k].scan];
+				fp->mz = clusters[k].mz;
+				fp->mass = ((double)clusters[k].mz - PROTON) * fp->charge;
+			}
+		}
+		i = j;
+	}
+
+	qsort(fl->features, fl->count, sizeof(Feature), compareFeature);
+	return fl;
+}
+
+
+FeatureListPointer readFeatureCache(XicStorePointer xs, char *filename,
+	char *path){
+	struct stat fileStat, cacheStat;
+	if(stat(path, &cacheStat) || stat(filename, &fileStat) ||
+		cacheStat.st_mtime < fileStat.st_mtime){
+		return NULL;
+	}
+
+	FILE *fp = fopen(path, "rb");
+	if(fp == NULL){
+		return NULL;
+	}
+
+	FeatureCache header;
+	if(fread(&header, sizeof(FeatureCache), 1, fp) != 1 ||
+		memcmp(header.magic, FEATURE_MAGIC, sizeof(header.magic)) ||
+		header.maxCharge != maxCharge ||
+		header.isotopicStates != isotopicStates ||
+		header.scanCount != xs->scanCount ||
+		header.ppmCutOff != ppmCutOff ||
+		header.intCutOff != intCutOff ||
+		header.count < 0){
+		fclose(fp);
+		return NULL;
+	}
+
+	FeatureListPointer fl = (FeatureListPointer)malloc(sizeof(FeatureList));
+	if(fl == NULL){
+		fclose(fp);
+		return NULL;
+	}
+	fl->count = header.count;
+	fl->features = (FeaturePointer)malloc( (header.count ? header.count : 1) *
+		sizeof(Feature));
+	if(fl->features == NULL || (int)fread(fl->features, sizeof(Feature),
+		header.count, fp) != header.count){
+		fclose(fp);
+		return delFeatureList(fl);
+	}
+	fclose(fp);
+	return fl;
+}
+
+
+void writeFeatureCache(XicStorePointer xs, FeatureListPointer fl, char *path){
+	FILE *fp = fopen(path, "wb");
+	if(fp == NULL){
+		fprintf(stderr, "\nWARNING: could not write feature cache %s\n", path);
+		return;
+	}
+
+	FeatureCache header;
+	memset(&header, 0, sizeof(FeatureCache));
+	memcpy(header.magic, FEATURE_MAGIC, sizeof(header.magic));
+	header.maxCharge = maxCharge;
+	header.isotopicStates = isotopicStates;
+	header.scanCount = xs->scanCount;
+	header.ppmCutOff = ppmCutOff;
+	header.intCutOff = intCutOff;
+	header.count = fl->count;
+
+	if(fwrite(&header, sizeof(FeatureCache), 1, fp) != 1 ||
+		(int)fwrite(fl->features, sizeof(Feature), fl->count, fp) != fl->count){
+		fprintf(stderr, "\nWARNING: could not write feature cache %s\n", path);
+		fclose(fp);
+		remove(path);
+		return;
+	}
+	fclose(fp);
+	return;
+}
+
+
+int compareCluster(const void *a, const void *b){
+	ClusterPointer ca = (ClusterPointer)a;
+	ClusterPointer cb = (ClusterPointer)b;
+	if(ca->charge != cb->charge){
+		return ca->charge - cb->charge;
+	}
+	if(ca->mz != cb->mz){
+		return ca->mz < cb->mz ? -1 : 1;
+	}
+	return ca->scan - cb->scan;
+}
+
+
+int compareClusterScan(const void *a, const void *b){
+	return ((ClusterPointer)a)->scan - ((ClusterPointer)b)->scan;
+}
+
+
+int compareFeature(const void *a, const void *b){
+	FeaturePointer fa = (FeaturePointer)a;
+	FeaturePointer fb = (FeaturePointer)b;
+	if(fa->mass != fb->mass){
+		return fa->mass < fb->mass ? -1 : 1;
+	}
+	return fa->first - fb->first;
+}
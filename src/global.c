@@ -22,14 +22,15 @@
  */
 
 #include "global.h"
+#include "isotope.h" //COMPOSITION_MODEL, CONVOLUTION_MODEL
+#include "ls.h" //LINEAR_ALIGN, ROBUST_ALIGN, LOWESS_ALIGN
+#include "records.h" //RecordsPointer, newRecords, nextRecord, fieldString
 
 #include <stdlib.h> //atoi, atof, malloc, exit
-#include <stdio.h> //fprintf, fopen, flcose, scanf, fgets, rewind
-#include <string.h> // strncpy, strlen, strcspn
+#include <stdio.h> //fprintf, fopen, flcose, scanf
+#include <string.h> // strncpy, strlen
 #include <stdbool.h>
 
-#define MAX_LINE 1024
-
 /*
  * printUsage - Print simple usage instructions.
  */
@@ -51,6 +52,12 @@ char **parseFileList(char *filelist_name);
  */
 bool file_exists(const char* filename);
 
+/*
+ * parseLongArg - Set the option named by a '--' prefixed argument. Return the
+ *     number of arguments consumed, or 0 if the option is not recognized.
+ */
+int parseLongArg(int argc, char *argv[], int i);
+
 void parseArgs(int argc, char *argv[]){
 	int i = 1;
 
@@ -156,6 +163,16 @@ void parseArgs(int argc, char *argv[]){
 				maxQuant = argv[i+1];
 				i+=2;
 				break;
+			case '-':
+				{
+					int consumed = parseLongArg(argc, argv, i);
+					if(!consumed){
+						printUsage();
+						exit(1);
+					}
+					i+=consumed;
+				}
+				break;
 			default:
 				printUsage();
 				exit(1);
@@ -232,75 +249,173 @@ void printHelp(){
 			"\t\t\tpattern generation and MS1 spectra interrogation.\n"
 			"\t\t\tDefault = 1\n"
 			"\t-v\t\tPrint the current version of PepQuant2\n"
+			"\n"
+			"Long options:\n"
+			"\t--charge-window integer\n"
+			"\t\t\tOnly search MS1 spectra at the charges a peptide was\n"
+			"\t\t\tidentified at in MS2, plus or minus this value.\n"
+			"\t\t\tCharges are taken from the search results and MS2\n"
+			"\t\t\tprecursor charges. Peptides with no known charge\n"
+			"\t\t\tare searched at every charge.\n"
+			"\t\t\tDefault = off\n"
+			"\t--features\tDetect isotope cluster features in each file\n"
+			"\t\t\tonce and only search the scans spanned by\n"
+			"\t\t\tfeatures matching a peptide's mass. Features are\n"
+			"\t\t\tcached next to each file as <file>.features and\n"
+			"\t\t\treused while the search parameters are unchanged.\n"
+			"\t--recalibrate\tFit the m/z error of each file from the MS1\n"
+			"\t\t\tpeaks of identified precursors as a function of\n"
+			"\t\t\tretention time and m/z. Correct the searched m/z\n"
+			"\t\t\tand search within three standard deviations of the\n"
+			"\t\t\tcorrected error (at most -p).\n"
+			"\t--streaming\tFold MS1 hits into a fixed size summary per\n"
+			"\t\t\tpeptide and file once the file is searched for\n"
+			"\t\t\tthe peptide rather than keeping every hit.\n"
+			"\t\t\tWindows about the MS1 apex or the MS2 retention\n"
+			"\t\t\ttime are quantified exactly. Windows about a\n"
+			"\t\t\tpredicted retention time, in files without an\n"
+			"\t\t\tidentification, are summed from retention time\n"
+			"\t\t\tbins within 2*-q of the apex, splitting bins\n"
+			"\t\t\tproportionally. searchResults.txt lists only the\n"
+			"\t\t\tapex of each file.\n"
+			"\t--mem-budget integer\n"
+			"\t\t\tSearch several mzXML files at once, largest first,\n"
+			"\t\t\twhile their estimated decoded size stays within\n"
+			"\t\t\tthis many MB. Files are searched one at a time\n"
+			"\t\t\twhen charge restriction is on.\n"
+			"\t\t\tDefault = 0 (one file at a time)\n"
+			"\t--isotope-model composition|convolution|averagine\n"
+			"\t\t\tcomposition computes the aggregated isotopes of\n"
+			"\t\t\teach peptide's elemental formula directly.\n"
+			"\t\t\tconvolution combines the fine structure of every\n"
+			"\t\t\tatom in turn, keeping the 32 most intense peaks.\n"
+			"\t\t\taveragine interpolates the isotopes of averagine\n"
+			"\t\t\tat each peptide's exact monoisotopic mass, a fast\n"
+			"\t\t\tapproximation for quick looks and large lists.\n"
+			"\t\t\tDefault = composition\n"
+			"\t--isotope-cache file\n"
+			"\t\t\tRead composition model isotopic patterns from\n"
+			"\t\t\tfile before generating patterns and save every\n"
+			"\t\t\tpattern to it afterwards.\n"
+			"\t--align linear|robust|lowess\n"
+			"\t\t\tlinear fits each run's retention times to the\n"
+			"\t\t\tmedians by least squares. robust refits with\n"
+			"\t\t\tHuber weights so outlying peptides pull the\n"
+			"\t\t\tline less. lowess follows gradient non-linearity\n"
+			"\t\t\twith a locally weighted curve, so a narrower -q\n"
+			"\t\t\tquantification window can be used.\n"
+			"\t\t\tDefault = linear\n"
 			);
 	return;
 }
 
+int parseLongArg(int argc, char *argv[], int i){
+	char *name = argv[i] + 2;
+
+	if(!strcmp(name, "charge-window") && i+1 < argc){
+		chargeWindow = atoi(argv[i+1]);
+		return 2;
+	}else if(!strcmp(name, "features")){
+		useFeatures = true;
+		return 1;
+	}else if(!strcmp(name, "recalibrate")){
+		recalibrate = true;
+		return 1;
+	}else if(!strcmp(name, "streaming")){
+		streaming = true;
+		return 1;
+	}else if(!strcmp(name, "mem-budget") && i+1 < argc){
+		memBudget = atoi(argv[i+1]);
+		return 2;
+	}else if(!strcmp(name, "isotope-model") && i+1 < argc){
+		if(!strcmp(argv[i+1], "composition")){
+			isotopeModel = COMPOSITION_MODEL;
+		}else if(!strcmp(argv[i+1], "convolution")){
+			isotopeModel = CONVOLUTION_MODEL;
+		}else if(!strcmp(argv[i+1], "averagine")){
+			isotopeModel = AVERAGINE_MODEL;
+		}else{
+			return 0;
+		}
+		return 2;
+	}else if(!strcmp(name, "align") && i+1 < argc){
+		if(!strcmp(argv[i+1], "linear")){
+			alignModel = LINEAR_ALIGN;
+		}else if(!strcmp(argv[i+1], "robust")){
+			alignModel = ROBUST_ALIGN;
+		}else if(!strcmp(argv[i+1], "lowess")){
+			alignModel = LOWESS_ALIGN;
+		}else{
+			return 0;
+		}
+		return 2;
+	}else if(!strcmp(name, "isotope-cache") && i+1 < argc){
+		isotopeCache = argv[i+1];
+		return 2;
+	}
+	return 0;
+}
+
 char **parseFileList(char *filelist_name){
 	char **filelist = NULL;
 
-	// open file
-	FILE *fp = fopen(filelist_name, "r");
-	if (!fp) {
+	// map the file
+	RecordsPointer rp = newRecords(filelist_name);
+	if (!rp) {
    		fprintf(stderr, "Error opening file: %s !\n", "filelist_name");
    		fprintf(stderr, "Will continue with auto-generated mzXML file list\n");
    		return NULL;
 	}
 
-	// count the number of lines in the file and reset file pointer
+	// count the number of non-empty lines in the file
 	size_t lines = 0;
-	char line[MAX_LINE];
-	while (fgets(line,sizeof(line),fp) != NULL)
+	const char *end = rp->data + rp->size;
+	const char *cursor = rp->data;
+	int length;
+	while (nextRecord(&cursor, end, &length) != NULL)
 	{
-		line[strcspn ( line, "\n" )] = '\0';
-		line[strcspn ( line, "\r" )] = '\0';
-		if(strlen(line))
+		if(length)
 		{
 			++lines;
 		}
 	}
 
-	rewind(fp);
-
 	// allocate room for file list
-	filelist = (char**)malloc(lines * sizeof(char *));
+	filelist = (char**)malloc((lines + 1) * sizeof(char *));
 	if (!filelist)
 	{
 		fprintf(stderr, "Could not allocate memory for file list\n");
    		fprintf(stderr, "Will continue with auto-generated mzXML file list\n");
+		rp = delRecords(rp);
    		return NULL;
 	}
 
 	// populate file list
-	//char line[MAX_LINE];
 	size_t count = 0;
-	while (fgets(line,sizeof(line),fp) != NULL)
+	const char *record;
+	cursor = rp->data;
+	while ((record = nextRecord(&cursor, end, &length)) != NULL)
 	{
-		/*remove newline*/
-		line[strcspn ( line, "\n" )] = '\0';
-		line[strcspn ( line, "\r" )] = '\0';
-		if (file_exists(line)){
-			int length = strlen(line);
-			char *filename = (char *)malloc(length + 1);
-			if(filename)
-			{
-				strncpy(filename, line, length+1);
-				filelist[count] = filename;
-				++count;
-			}
-			else
-			{
-				fprintf(stderr, "Memory for file %s could not be allocated!"
-						"(skipping)\n", line);
-			}
+		if(!length)
+		{
+			continue;
+		}
+		Field field = {record, length};
+		char *filename = NULL;
+		int size = 0;
+		fieldString(&field, NULL, &filename, &size);
+		if (file_exists(filename)){
+			filelist[count] = filename;
+			++count;
 		}
 		else
 		{
 			fprintf(stderr, "File: %s, could not be opened! (skipping)\n",
-					line);
+					filename);
+			free(filename);
 		}
 	}
-	fclose(fp);
+	rp = delRecords(rp);
 	dataCount = count;
 	return filelist;
 }
@@ -0,0 +1,144 @@
+/*
+ * graph.c                                                                   
+ * =======                                                                   
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for building a graph of pipeline stages and running it on       
+ *     the thread pool so that independent stages overlap.                   
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "graph.h"
+#include "pool.h" //poolGraph, poolSpawn
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, realloc, free, exit
+
+/*
+ * runStage - Pool task running a single stage and spawning the dependents it
+ *     was the last dependency of.
+ */
+void runStage(void *ptr, int index, int worker);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+GraphPointer newGraph(void){
+	GraphPointer gp = (GraphPointer)malloc(sizeof(Graph));
+	if(gp == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create graph!\n");
+		return NULL;
+	}
+	gp->count = 0;
+	gp->size = 0;
+	gp->stages = NULL;
+	pthread_mutex_init(&gp->lock, NULL);
+	return gp;
+}
+
+
+GraphPointer delGraph(GraphPointer gp){
+	if(gp == NULL){
+		return NULL;
+	}
+	int i;
+	for(i = 0; i < gp->count; ++i){
+		free(gp->stages[i]);
+	}
+	free(gp->stages);
+	pthread_mutex_destroy(&gp->lock);
+	free(gp);
+	gp = NULL;
+	return gp;
+}
+
+
+StagePointer addStage(GraphPointer gp, char *name, StageFunc run, void *arg){
+	if(gp->count == gp->size){
+		int size = gp->size ? 2*gp->size : 16;
+		StagePointer *tmp = (StagePointer *)realloc(gp->stages,
+			size * sizeof(StagePointer));
+		if(tmp == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot add stage!\n");
+			exit(1);
+		}
+		gp->stages = tmp;
+		gp->size = size;
+	}
+	StagePointer sp = (StagePointer)malloc(sizeof(Stage));
+	if(sp == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot add stage!\n");
+		exit(1);
+	}
+	sp->name = name;
+	sp->run = run;
+	sp->arg = arg;
+	sp->index = gp->count;
+	sp->pending = 0;
+	sp->dependentCount = 0;
+	gp->stages[gp->count++] = sp;
+	return sp;
+}
+
+
+void stageAfter(StagePointer stage, StagePointer dependency){
+	if(dependency->dependentCount == MAX_DEPENDENTS){
+		fprintf(stderr, "\nERROR: stage %s has too many dependents!\n",
+			dependency->name);
+		exit(1);
+	}
+	dependency->dependents[dependency->dependentCount++] = stage;
+	stage->pending++;
+	return;
+}
+
+
+void runGraph(GraphPointer gp){
+	int *ready = (int *)malloc( (gp->count ? gp->count : 1) * sizeof(int));
+	if(ready == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot run graph!\n");
+		exit(1);
+	}
+	int i;
+	int readyCount = 0;
+	for(i = 0; i < gp->count; ++i){
+		if(gp->stages[i]->pending == 0){
+			ready[readyCount++] = i;
+		}
+	}
+	poolGraph(gp->count, ready, readyCount, runStage, (void *)gp);
+	free(ready);
+	return;
+}
+
+
+void runStage(void *ptr, int index, int worker){
+	GraphPointer gp = (GraphPointer)ptr;
+	StagePointer sp = gp->stages[index];
+	sp->run(sp->arg);
+
+	int i;
+	pthread_mutex_lock(&gp->lock);
+	for(i = 0; i < sp->dependentCount; ++i){
+		if(--sp->dependents[i]->pending == 0){
+			poolSpawn(sp->dependents[i]->index);
+		}
+	}
+	pthread_mutex_unlock(&gp->lock);
+	return;
+}
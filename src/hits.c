@@ -0,0 +1,324 @@
+/*
+ * hits.c                                                                    
+ * ======                                                                    
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for building compressed sparse row stores of peptide hits from  
+ *     identified ms2 scans and from the ms1 hits buffered while searching   
+ *     each spectra file.                                                    
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "hits.h"
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, calloc, realloc, free, qsort
+#include <string.h> //memcpy, memmove
+
+#define BUFFER_SIZE 8 //initial hits of a hit buffer
+
+/*
+ * compareKeys - Order HitKeys by row, column and scan.
+ */
+int compareKeys(const void *a, const void *b);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+HitStorePointer newHitStore(int rowCount, int runCount, int hitCount,
+	int width, bool withCorr){
+	HitStorePointer hs = (HitStorePointer)calloc(1, sizeof(HitStore));
+	if(hs == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create hit store!\n");
+		return NULL;
+	}
+	hs->rowCount = rowCount;
+	hs->runCount = runCount;
+	hs->hitCount = hitCount;
+	hs->width = width;
+	hs->runStart = (int *)calloc(rowCount + 1, sizeof(int));
+	hs->runColumn = (int *)malloc( (runCount ? runCount : 1) * sizeof(int));
+	hs->hitStart = (int *)calloc(runCount + 1, sizeof(int));
+	hs->scanNum = (int *)malloc( (hitCount ? hitCount : 1) * sizeof(int));
+	hs->rt = (double *)calloc(hitCount ? hitCount : 1, sizeof(double));
+	hs->intensity = (float *)calloc(hitCount ? hitCount*width : 1,
+		sizeof(float));
+	if(withCorr){
+		hs->corr = (float *)calloc(hitCount ? hitCount*width : 1,
+			sizeof(float));
+	}
+	if(hs->runStart == NULL || hs->runColumn == NULL ||
+		hs->hitStart == NULL || hs->scanNum == NULL || hs->rt == NULL ||
+		hs->intensity == NULL || (withCorr && hs->corr == NULL) ){
+
+		fprintf(stderr, "\nERROR: Out of memory - cannot create hit store!\n");
+		return delHitStore(hs);
+	}
+	return hs;
+}
+
+
+HitStorePointer delHitStore(HitStorePointer hs){
+	if(hs == NULL){
+		return NULL;
+	}
+	free(hs->runStart);
+	free(hs->runColumn);
+	free(hs->hitStart);
+	free(hs->scanNum);
+	free(hs->rt);
+	free(hs->intensity);
+	free(hs->corr);
+	free(hs);
+	hs = NULL;
+	return hs;
+}
+
+
+int compareKeys(const void *a, const void *b){
+	HitKeyPointer x = (HitKeyPointer)a;
+	HitKeyPointer y = (HitKeyPointer)b;
+	if(x->row != y->row){
+		return x->row < y->row ? -1 : 1;
+	}
+	if(x->column != y->column){
+		return x->column < y->column ? -1 : 1;
+	}
+	return (x->scanNum > y->scanNum) - (x->scanNum < y->scanNum);
+}
+
+
+HitStorePointer keyedHits(HitKeyPointer keys, int count, int rowCount){
+	int i;
+	qsort(keys, count, sizeof(HitKey), compareKeys);
+
+	/*count the distinct hits and runs*/
+	int hitCount = 0;
+	int runCount = 0;
+	HitKeyPointer last = NULL;
+	for(i = 0; i < count; ++i){
+		HitKeyPointer k = keys + i;
+		if(k->row < 0 || k->row >= rowCount || k->column < 0){
+			continue;
+		}
+		if(last == NULL || k->row != last->row || k->column != last->column){
+			runCount++;
+		}else if(k->scanNum == last->scanNum){
+			continue;
+		}
+		hitCount++;
+		last = k;
+	}
+
+	HitStorePointer hs = newHitStore(rowCount, runCount, hitCount, 1, false);
+	if(hs == NULL){
+		return NULL;
+	}
+	int run = -1;
+	int hit = 0;
+	last = NULL;
+	for(i = 0; i < count; ++i){
+		HitKeyPointer k = keys + i;
+		if(k->row < 0 || k->row >= rowCount || k->column < 0){
+			continue;
+		}
+		if(last == NULL || k->row != last->row || k->column != last->column){
+			run++;
+			hs->runColumn[run] = k->column;
+			hs->hitStart[run] = hit;
+			hs->runStart[k->row + 1] = run + 1;
+		}else if(k->scanNum == last->scanNum){
+			continue;
+		}
+		hs->scanNum[hit++] = k->scanNum;
+		last = k;
+	}
+	hs->hitStart[runCount] = hit;
+
+	/*rows without runs start where the previous row ended*/
+	for(i = 1; i <= rowCount; ++i){
+		if(hs->runStart[i] < hs->runStart[i-1]){
+			hs->runStart[i] = hs->runStart[i-1];
+		}
+	}
+	return hs;
+}
+
+
+int findRun(HitStorePointer hs, int row, int column){
+	if(row < 0 || row >= hs->rowCount){
+		return -1;
+	}
+	int low = hs->runStart[row];
+	int high = hs->runStart[row+1];
+	while(low < high){
+		int mid = low + (high - low)/2;
+		if(hs->runColumn[mid] < column){
+			low = mid + 1;
+		}else{
+			high = mid;
+		}
+	}
+	return (low < hs->runStart[row+1] && hs->runColumn[low] == column)?
+		low : -1;
+}
+
+
+int bufferHit(HitBufferPointer hb, int width, int scanNum, float *intensity,
+	float *corr){
+
+	/*hits nearly always arrive in scan order so search from the back*/
+	int i = hb->count;
+	while(i > 0 && hb->scanNum[i-1] > scanNum){
+		--i;
+	}
+	if(i > 0 && hb->scanNum[i-1] == scanNum){
+		return 0;
+	}
+
+	if(hb->count == hb->size){
+		int size = hb->size ? 2*hb->size : BUFFER_SIZE;
+		int *scans = (int *)realloc(hb->scanNum, size * sizeof(int));
+		if(scans != NULL){
+			hb->scanNum = scans;
+		}
+		float *values = (float *)realloc(hb->intensity,
+			size * width * sizeof(float));
+		if(values != NULL){
+			hb->intensity = values;
+		}
+		float *corrs = (float *)realloc(hb->corr,
+			size * width * sizeof(float));
+		if(corrs != NULL){
+			hb->corr = corrs;
+		}
+		if(scans == NULL || values == NULL || corrs == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot record hit!\n");
+			return -1;
+		}
+		hb->size = size;
+	}
+
+	if(i < hb->count){
+		int n = hb->count - i;
+		memmove(hb->scanNum + i + 1, hb->scanNum + i, n * sizeof(int));
+		memmove(hb->intensity + (i+1)*width, hb->intensity + i*width,
+			n * width * sizeof(float));
+		memmove(hb->corr + (i+1)*width, hb->corr + i*width,
+			n * width * sizeof(float));
+	}
+	hb->scanNum[i] = scanNum;
+	memcpy(hb->intensity + i*width, intensity, width * sizeof(float));
+	memcpy(hb->corr + i*width, corr, width * sizeof(float));
+	hb->count++;
+	return 0;
+}
+
+
+void freeBuffer(HitBufferPointer hb){
+	free(hb->scanNum);
+	free(hb->intensity);
+	free(hb->corr);
+	hb->scanNum = NULL;
+	hb->intensity = NULL;
+	hb->corr = NULL;
+	hb->count = 0;
+	hb->size = 0;
+	return;
+}
+
+
+HitStorePointer bufferedHits(HitBufferPointer buffers, int rowCount,
+	int column, int width){
+	int i;
+	int runCount = 0;
+	int hitCount = 0;
+	for(i = 0; i < rowCount; ++i){
+		runCount += buffers[i].count > 0;
+		hitCount += buffers[i].count;
+	}
+
+	HitStorePointer hs = newHitStore(rowCount, runCount, hitCount, width,
+		true);
+	int run = 0;
+	int hit = 0;
+	for(i = 0; i < rowCount; ++i){
+		HitBufferPointer hb = buffers + i;
+		if(hs != NULL && hb->count > 0){
+			hs->runColumn[run] = column;
+			hs->hitStart[run++] = hit;
+			memcpy(hs->scanNum + hit, hb->scanNum, hb->count * sizeof(int));
+			memcpy(hs->intensity + hit*width, hb->intensity,
+				hb->count * width * sizeof(float));
+			memcpy(hs->corr + hit*width, hb->corr,
+				hb->count * width * sizeof(float));
+			hit += hb->count;
+		}
+		if(hs != NULL){
+			hs->runStart[i+1] = run;
+			hs->hitStart[run] = hit;
+		}
+		freeBuffer(hb);
+	}
+	return hs;
+}
+
+
+HitStorePointer mergeHits(HitStorePointer *parts, int partCount,
+	int rowCount, int width, bool withCorr){
+	int i, p;
+	int runCount = 0;
+	int hitCount = 0;
+	for(p = 0; p < partCount; ++p){
+		runCount += parts[p]->runCount;
+		hitCount += parts[p]->hitCount;
+	}
+
+	HitStorePointer hs = newHitStore(rowCount, runCount, hitCount, width,
+		withCorr);
+	int run = 0;
+	int hit = 0;
+	for(i = 0; hs != NULL && i < rowCount; ++i){
+		for(p = 0; p < partCount; ++p){
+			HitStorePointer part = parts[p];
+			int u;
+			for(u = part->runStart[i]; u < part->runStart[i+1]; ++u){
+				int first = part->hitStart[u];
+				int n = part->hitStart[u+1] - first;
+				hs->runColumn[run] = part->runColumn[u];
+				hs->hitStart[run++] = hit;
+				memcpy(hs->scanNum + hit, part->scanNum + first,
+					n * sizeof(int));
+				memcpy(hs->rt + hit, part->rt + first, n * sizeof(double));
+				memcpy(hs->intensity + hit*width, part->intensity +
+					first*width, n * width * sizeof(float));
+				if(withCorr){
+					memcpy(hs->corr + hit*width, part->corr + first*width,
+						n * width * sizeof(float));
+				}
+				hit += n;
+			}
+		}
+		hs->runStart[i+1] = run;
+		hs->hitStart[run] = hit;
+	}
+	for(p = 0; p < partCount; ++p){
+		parts[p] = delHitStore(parts[p]);
+	}
+	return hs;
+}
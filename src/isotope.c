@@ -29,10 +29,16 @@
 
 #include <stdio.h> //printf, fprintf
 #include <stdlib.h> //malloc, free
-#include <string.h> //memcpy
-#include <math.h> //fabs
+#include <string.h> //memcpy, memset
+#include <math.h> //fabs, floor
 #include <ctype.h> //isupper
 
+#define NOT_RESIDUE -2 //sequence characters that are not residues or mods
+#define AVERAGINE_MASS 111.1254 //mass of one averagine unit
+#define AVERAGINE_STEP 20.0 //mass between rows of the averagine table
+#define AVERAGINE_ROWS 1000 //rows of the averagine table, up to 20 kDa
+#define C13_SHIFT 1.0033548378 //mass difference between 13C and 12C
+
 /*Elemental data, BLANK for initializing IsotopicPattern structs*/
 //http://www.chem.ualberta.ca/~massspec/atomic_mass_abund.pdf
 float BLANK[ISOTOPE_COUNT] = {1}; 
@@ -58,6 +64,64 @@ float C13_MASS[ISOTOPE_COUNT] = {13.003355, 0}; //heavy
 float N15[ISOTOPE_COUNT] = {1, 0}; //heavy
 float N15_MASS[ISOTOPE_COUNT] = {15.000109, 0}; //heavy
 
+/*Elemental patterns in the order of the Element enum*/
+float *ELEMENTS[ELEMENT_COUNT] = {C, H, N, O, P, S, Se, C13, N15};
+float *ELEMENTS_MASS[ELEMENT_COUNT] = {C_MASS, H_MASS, N_MASS, O_MASS, P_MASS,
+	S_MASS, Se_MASS, C13_MASS, N15_MASS};
+
+/*Residue compositions minus a water, indexed as the IPCollection*/
+int RESIDUES[COLLECTION_SIZE][ELEMENT_COUNT] = {
+	['A'] = {3, 5, 1, 1, 0, 0, 0, 0, 0}, //Ala A
+	['R'] = {6, 12, 4, 1, 0, 0, 0, 0, 0}, //Arg R
+	['N'] = {4, 6, 2, 2, 0, 0, 0, 0, 0}, //Asn N
+	['D'] = {4, 5, 1, 3, 0, 0, 0, 0, 0}, //Asp D
+	['C'] = {3, 5, 1, 1, 0, 1, 0, 0, 0}, //Cys C
+	['Q'] = {5, 8, 2, 2, 0, 0, 0, 0, 0}, //Gln Q
+	['E'] = {5, 7, 1, 3, 0, 0, 0, 0, 0}, //Glu E
+	['G'] = {2, 3, 1, 1, 0, 0, 0, 0, 0}, //Gly G
+	['H'] = {6, 7, 3, 1, 0, 0, 0, 0, 0}, //His H
+	['I'] = {6, 11, 1, 1, 0, 0, 0, 0, 0}, //Ile I
+	['L'] = {6, 11, 1, 1, 0, 0, 0, 0, 0}, //Leu L
+	['K'] = {6, 12, 2, 1, 0, 0, 0, 0, 0}, //Lys K
+	['M'] = {5, 9, 1, 1, 0, 1, 0, 0, 0}, //Met M
+	['F'] = {9, 9, 1, 1, 0, 0, 0, 0, 0}, //Phe F
+	['P'] = {5, 7, 1, 1, 0, 0, 0, 0, 0}, //Pro P
+	['S'] = {3, 5, 1, 2, 0, 0, 0, 0, 0}, //Ser S
+	['T'] = {4, 7, 1, 2, 0, 0, 0, 0, 0}, //Thr T
+	['W'] = {11, 10, 2, 1, 0, 0, 0, 0, 0}, //Trp W
+	['Y'] = {9, 9, 1, 2, 0, 0, 0, 0, 0}, //Tyr Y
+	['V'] = {5, 9, 1, 1, 0, 0, 0, 0, 0}, //Val V
+	['U'] = {3, 5, 1, 1, 0, 0, 1, 0, 0}, //Sec U
+	['r'+10] = {0, 12, 0, 1, 0, 0, 0, 6, 4}, //arg-10
+	['r'+6] = {0, 12, 4, 1, 0, 0, 0, 6, 0}, //arg-6
+	['r'+4] = {6, 12, 0, 1, 0, 0, 0, 0, 4}, //arg-4
+	['k'-8] = {0, 12, 0, 1, 0, 0, 0, 6, 2}, //lys-8
+	['k'-6] = {0, 12, 2, 1, 0, 0, 0, 6, 0}, //lys-6
+	['k'-2] = {6, 12, 0, 1, 0, 0, 0, 0, 2}, //lys-2
+	[0] = {0, 2, 0, 1, 0, 0, 0, 0, 0}, //H2O
+	[1] = {0, 1, 0, 3, 1, 0, 0, 0, 0}, //P03H (ph)
+	[2] = {0, 0, 0, 1, 0, 0, 0, 0, 0}, //O (ox)
+	[3] = {2, 2, 0, 1, 0, 0, 0, 0, 0}, //C2H2O (ac)
+	[4] = {2, 3, 1, 1, 0, 0, 0, 0, 0} //H3C2NO (cb)
+};
+
+/*Averagine atoms per unit in the order of the Element enum (Senko et al.)*/
+double AVERAGINE[ELEMENT_COUNT] = {4.9384, 7.7583, 1.3577, 1.4773, 0, 0.0417,
+	0, 0, 0};
+
+/*Averagine isotope intensities and mass shifts from the monoisotope by mass*/
+float averagineIntensity[AVERAGINE_ROWS][AGGREGATE_COUNT];
+float averagineShift[AVERAGINE_ROWS][AGGREGATE_COUNT];
+
+/*
+ * aggregate - intensities of isotopes by nominal mass offset from the lightest
+ *     isotopologue, along with the intensity weighted sum of their masses.
+ */
+typedef struct aggregate{
+	double intensity[AGGREGATE_COUNT];
+	double massSum[AGGREGATE_COUNT];
+}Aggregate, *AggregatePointer;
+
 /*
  * newIsotopicPattern - Allocate memory for a new IsotopicPattern and init with
  *     passed values. Return a pointer to new IsotopicPattern, NULL if error
@@ -101,6 +165,52 @@ void merge(float *intensity, float *mass, int left, int right);
  */
 void swapEntries(float *intensity, float *mass, int i, int j);
 
+/*
+ * residueIndex - Return the IPCollection index of the residue or mod starting
+ *     at sequence[*i] and leave *i on its last character. Return NOT_RESIDUE
+ *     for characters that are not part of the peptide and -1 if the character
+ *     is unknown.
+ */
+int residueIndex(char *sequence, int *i, int isHeavy);
+
+/*
+ * finishPeptide - Add the water missing from the ends of a chain of residue
+ *     patterns and keep only the isotopicStates most intense isotopes.
+ */
+IsotopicPatternPointer finishPeptide(IsotopicPatternPointer *IPCollection,
+	IsotopicPatternPointer peptide);
+
+/*
+ * composeAggregate - Store the aggregate of a molecule with the passed
+ *     elemental composition in molecule.
+ */
+void composeAggregate(int *composition, AggregatePointer molecule);
+
+/*
+ * aggregatePattern - Create an IsotopicPattern of the isotopicStates most
+ *     intense isotopes of the aggregate. Return NULL if an error occured.
+ */
+IsotopicPatternPointer aggregatePattern(AggregatePointer molecule);
+
+/*
+ * elementAggregate - Fill the aggregate with the isotopes of a single atom of
+ *     the element.
+ */
+void elementAggregate(int element, AggregatePointer ap);
+
+/*
+ * convolveAggregates - Store the aggregate of the molecule made of molecules
+ *     a and b in result. result may be either a or b.
+ */
+void convolveAggregates(AggregatePointer a, AggregatePointer b,
+	AggregatePointer result);
+
+/*
+ * powerAggregate - Store the aggregate of count copies of the molecule base
+ *     in result using exponentiation by squaring. base is overwritten.
+ */
+void powerAggregate(AggregatePointer base, int count, AggregatePointer result);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //                       END OF FUNCTION DECLARATIONS                        //
@@ -170,6 +280,211 @@ IsotopicPatternPointer combineIsotopicPatterns(IsotopicPatternPointer ipp1,
 }
 
 
+void elementAggregate(int element, AggregatePointer ap){
+	float *intensity = ELEMENTS[element];
+	float *mass = ELEMENTS_MASS[element];
+	int i;
+	memset(ap, 0, sizeof(Aggregate));
+	for(i = 0; i < ISOTOPE_COUNT && intensity[i] != 0; ++i){
+		int offset = (int)floor(mass[i] - mass[0] + 0.5);
+		if(offset >= 0 && offset < AGGREGATE_COUNT){
+			ap->intensity[offset] += intensity[i];
+			ap->massSum[offset] += (double)intensity[i] * mass[i];
+		}
+	}
+	return;
+}
+
+
+void convolveAggregates(AggregatePointer a, AggregatePointer b,
+	AggregatePointer result){
+
+	Aggregate product;
+	memset(&product, 0, sizeof(Aggregate));
+	int i, j;
+	for(i = 0; i < AGGREGATE_COUNT; ++i){
+		if(a->intensity[i] == 0){
+			continue;
+		}
+		for(j = 0; i + j < AGGREGATE_COUNT; ++j){
+			product.intensity[i+j] += a->intensity[i] * b->intensity[j];
+			product.massSum[i+j] += a->massSum[i] * b->intensity[j] +
+				a->intensity[i] * b->massSum[j];
+		}
+	}
+	memcpy(result, &product, sizeof(Aggregate));
+	return;
+}
+
+
+void powerAggregate(AggregatePointer base, int count, AggregatePointer result){
+	memset(result, 0, sizeof(Aggregate));
+	result->intensity[0] = 1;
+	while(count > 0){
+		if(count & 1){
+			convolveAggregates(result, base, result);
+		}
+		count >>= 1;
+		if(count > 0){
+			convolveAggregates(base, base, base);
+		}
+	}
+	return;
+}
+
+
+int encodePeptide(char *sequence, unsigned char *codes){
+	int length = strlen(sequence);
+	int i;
+	int count = 0;
+	int isHeavy = sequence[0] == '*'? 1: 0;
+
+	for(i = 0; i < length; ++i){ //might actually loop less than length times
+		int residue = residueIndex(sequence, &i, isHeavy);
+		if(residue == NOT_RESIDUE){
+			continue;
+		}else if(residue < 0){
+			return -1;
+		}
+		codes[count++] = (unsigned char)residue;
+	}
+	return count;
+}
+
+
+void peptideComposition(const unsigned char *codes, int count,
+	int *composition){
+	int i, j;
+
+	memset(composition, 0, ELEMENT_COUNT * sizeof(int));
+	for(i = 0; i < count; ++i){
+		for(j = 0; j < ELEMENT_COUNT; ++j){
+			composition[j] += RESIDUES[codes[i]][j];
+		}
+	}
+	/*compensate for missing water at peptide ends*/
+	for(j = 0; j < ELEMENT_COUNT; ++j){
+		composition[j] += RESIDUES[0][j];
+	}
+	return;
+}
+
+
+IsotopicPatternPointer makeComposition(int *composition){
+	Aggregate molecule;
+	composeAggregate(composition, &molecule);
+	return aggregatePattern(&molecule);
+}
+
+
+void initAveragine(void){
+	int row, i, k;
+	for(row = 0; row < AVERAGINE_ROWS; ++row){
+		/*nearest whole number of atoms of the averagine at the row's mass*/
+		double units = row * AVERAGINE_STEP / AVERAGINE_MASS;
+		int composition[ELEMENT_COUNT];
+		memset(composition, 0, ELEMENT_COUNT * sizeof(int));
+		for(i = 0; i < ELEMENT_COUNT; ++i){
+			composition[i] = (int)floor(units * AVERAGINE[i] + 0.5);
+		}
+
+		Aggregate molecule;
+		composeAggregate(composition, &molecule);
+		double monoisotopic = molecule.intensity[0] == 0? 0 :
+			molecule.massSum[0] / molecule.intensity[0];
+		for(k = 0; k < AGGREGATE_COUNT; ++k){
+			averagineIntensity[row][k] = molecule.intensity[k];
+			averagineShift[row][k] = molecule.intensity[k] == 0? k * C13_SHIFT :
+				molecule.massSum[k] / molecule.intensity[k] - monoisotopic;
+		}
+	}
+	return;
+}
+
+
+IsotopicPatternPointer makeAveragine(int *composition){
+	int i, k;
+	double monoisotopic = 0;
+	for(i = 0; i < ELEMENT_COUNT; ++i){
+		monoisotopic += composition[i] * (double)ELEMENTS_MASS[i][0];
+	}
+
+	/*interpolate between the rows either side of the mass*/
+	double position = monoisotopic / AVERAGINE_STEP;
+	int row = (int)position;
+	double fraction = position - row;
+	if(row >= AVERAGINE_ROWS - 1){
+		row = AVERAGINE_ROWS - 2;
+		fraction = 1;
+	}
+
+	Aggregate molecule;
+	for(k = 0; k < AGGREGATE_COUNT; ++k){
+		double intensity = (1 - fraction) * averagineIntensity[row][k] +
+			fraction * averagineIntensity[row+1][k];
+		double shift = (1 - fraction) * averagineShift[row][k] +
+			fraction * averagineShift[row+1][k];
+		molecule.intensity[k] = intensity;
+		molecule.massSum[k] = intensity * (monoisotopic + shift);
+	}
+	return aggregatePattern(&molecule);
+}
+
+
+void composeAggregate(int *composition, AggregatePointer molecule){
+	Aggregate element, power;
+	int i;
+
+	memset(molecule, 0, sizeof(Aggregate));
+	molecule->intensity[0] = 1;
+	for(i = 0; i < ELEMENT_COUNT; ++i){
+		if(composition[i] > 0){
+			elementAggregate(i, &element);
+			powerAggregate(&element, composition[i], &power);
+			convolveAggregates(molecule, &power, molecule);
+		}
+	}
+	return;
+}
+
+
+IsotopicPatternPointer aggregatePattern(AggregatePointer molecule){
+	int i, j;
+
+	/*order the nominal isotopes by decreasing intensity*/
+	int order[AGGREGATE_COUNT];
+	for(i = 0; i < AGGREGATE_COUNT; ++i){
+		for(j = i; j > 0 && molecule->intensity[i] >
+			molecule->intensity[order[j-1]]; --j){
+			order[j] = order[j-1];
+		}
+		order[j] = i;
+	}
+
+	IsotopicPatternPointer ipp = (IsotopicPatternPointer)malloc(
+		sizeof(IsotopicPattern));
+	if(ipp == NULL){
+		fprintf(stderr,
+			"\nERROR: Out of memory - cannot create isotopic pattern.\n");
+		return NULL;
+	}
+	ipp->intensity = (float*)calloc(isotopicStates, sizeof(float));
+	ipp->mass = (float*)calloc(isotopicStates, sizeof(float));
+	if(ipp->intensity == NULL || ipp->mass == NULL){
+		fprintf(stderr,
+			"\nERROR: Out of memory - cannot create isotopic pattern.\n");
+		return delIsotopicPattern(ipp);
+	}
+	for(i = 0; i < isotopicStates && i < AGGREGATE_COUNT; ++i){
+		double intensity = molecule->intensity[order[i]];
+		ipp->intensity[i] = intensity;
+		ipp->mass[i] = intensity == 0? 0 :
+			molecule->massSum[order[i]] / intensity;
+	}
+	return ipp;
+}
+
+
 IsotopicPatternPointer makeMolecule(int CCount, int HCount, int NCount,
 	int OCount, int PCount, int SCount, int C13Count, int N15Count){
 
@@ -420,53 +735,142 @@ IsotopicPatternPointer* delIPCollection(IsotopicPatternPointer *IPCollection){
 
 
 IsotopicPatternPointer makePeptide(
-	IsotopicPatternPointer *IPCollection, char *sequence){
+	IsotopicPatternPointer *IPCollection, const unsigned char *codes,
+	int count){
 
-	int length = strlen(sequence);
 	int i;
-	int isHeavy = sequence[0] == '*'? 1: 0;
 	
 	IsotopicPatternPointer peptide = newIsotopicPattern(BLANK, BLANK_MASS);
-	for(i = 0; i < length; ++i){ //might actually loop less than length times
-		if(sequence[i] == '_' || sequence[i] == '.' ||  sequence[i] == '*'){
-			;
-		}else if(sequence[i] == '('){
-			i++;
-			IsotopicPatternPointer temp = NULL;
-			if(sequence[i] =='a'){
-				temp = combineIsotopicPatterns(peptide, IPCollection[3]);
-			}else if(sequence[i] =='o'){
-				temp = combineIsotopicPatterns(peptide, IPCollection[2]);
-			}else if(sequence[i] =='p'){
-				temp = combineIsotopicPatterns(peptide, IPCollection[1]);
-			}else if(sequence[i] =='c'){
-				temp = combineIsotopicPatterns(peptide, IPCollection[4]);
-			}else{
-				printf("Unknown mod in seq: %s\n", sequence);
-			}
-			delIsotopicPattern(peptide);
-			peptide = temp;
-			i+=2; //to skip rest of mod
-		}else if(strchr(AMINO_ACIDS, sequence[i])){
-			IsotopicPatternPointer temp = NULL;
-			if(isHeavy && lys && sequence[i] == 'K'){
-				temp = combineIsotopicPatterns(peptide, 
-					IPCollection[(int)'k' - lys]); 				
-			}else if(isHeavy && arg && sequence[i] == 'R'){
-				temp = combineIsotopicPatterns(peptide, 
-					IPCollection[(int)'r' + arg]); 
-			}else{
-				temp = combineIsotopicPatterns(peptide, 
-					IPCollection[(int)sequence[i]]); 
-			}
-			delIsotopicPattern(peptide);
-			peptide = temp;
+	for(i = 0; i < count; ++i){
+		IsotopicPatternPointer temp =
+			combineIsotopicPatterns(peptide, IPCollection[codes[i]]);
+		delIsotopicPattern(peptide);
+		peptide = temp;
+	}
+	return finishPeptide(IPCollection, peptide);
+}
+
+
+PrefixStackPointer newPrefixStack(void){
+	PrefixStackPointer ps = (PrefixStackPointer)malloc(sizeof(PrefixStack));
+	if(ps == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create stack!\n");
+		return NULL;
+	}
+	ps->codes = NULL;
+	ps->length = 0;
+	ps->size = 0;
+	ps->patterns = NULL;
+	return ps;
+}
+
+
+PrefixStackPointer delPrefixStack(PrefixStackPointer ps){
+	if(ps == NULL){
+		return NULL;
+	}
+	int i;
+	for(i = 0; i < ps->size; ++i){
+		delIsotopicPattern(ps->patterns[i]);
+	}
+	free(ps->patterns);
+	free(ps->codes);
+	free(ps);
+	ps = NULL;
+	return ps;
+}
+
+
+IsotopicPatternPointer makePeptidePrefix(IsotopicPatternPointer *IPCollection,
+	PrefixStackPointer ps, const unsigned char *codes, int count){
+
+	int i;
+
+	if(ps->size < count + 1){
+		IsotopicPatternPointer *patterns = (IsotopicPatternPointer *)realloc(
+			ps->patterns, (count + 1) * sizeof(IsotopicPatternPointer));
+		unsigned char *copy = (unsigned char *)realloc(ps->codes, count + 1);
+		if(patterns != NULL){
+			ps->patterns = patterns;
+		}
+		if(copy != NULL){
+			ps->codes = copy;
+		}
+		/*size covers both buffers, so it only grows once both have*/
+		if(patterns == NULL || copy == NULL){
+			return makePeptide(IPCollection, codes, count);
+		}
+		for(i = ps->size; i < count + 1; ++i){
+			ps->patterns[i] = NULL;
+		}
+		ps->size = count + 1;
+	}
+
+	/*find the longest shared prefix*/
+	int shared = 0;
+	while(shared < count && shared < ps->length &&
+		codes[shared] == ps->codes[shared]){
+		shared++;
+	}
+	for(i = shared + 1; i < ps->size; ++i){
+		ps->patterns[i] = delIsotopicPattern(ps->patterns[i]);
+	}
+	if(ps->patterns[0] == NULL){
+		ps->patterns[0] = newIsotopicPattern(BLANK, BLANK_MASS);
+	}
+	memcpy(ps->codes, codes, count);
+	ps->length = count;
+
+	/*extend the shared prefix by the rest of the sequence*/
+	IsotopicPatternPointer peptide = ps->patterns[shared];
+	for(i = shared; i < count; ++i){
+		peptide = combineIsotopicPatterns(peptide, IPCollection[codes[i]]);
+		ps->patterns[i + 1] = peptide;
+	}
+	/*extended patterns are kept by the stack, the peptide gets a copy*/
+	IsotopicPatternPointer copy = newIsotopicPattern(peptide->intensity,
+		peptide->mass);
+	return finishPeptide(IPCollection, copy);
+}
+
+
+int residueIndex(char *sequence, int *i, int isHeavy){
+	char c = sequence[*i];
+	if(c == '_' || c == '.' ||  c == '*'){
+		return NOT_RESIDUE;
+	}else if(c == '('){
+		(*i)++;
+		int mod = -1;
+		if(sequence[*i] =='a'){
+			mod = 3;
+		}else if(sequence[*i] =='o'){
+			mod = 2;
+		}else if(sequence[*i] =='p'){
+			mod = 1;
+		}else if(sequence[*i] =='c'){
+			mod = 4;
 		}else{
-			fprintf(stderr, "\nERROR: Unknown char[%c] in sequence: %s.\n",
-				sequence[i], sequence);
-			return NULL;
+			printf("Unknown mod in seq: %s\n", sequence);
+		}
+		(*i)+=2; //to skip rest of mod
+		return mod;
+	}else if(strchr(AMINO_ACIDS, c)){
+		if(isHeavy && lys && c == 'K'){
+			return (int)'k' - lys;
+		}else if(isHeavy && arg && c == 'R'){
+			return (int)'r' + arg;
 		}
+		return (int)c;
 	}
+	fprintf(stderr, "\nERROR: Unknown char[%c] in sequence: %s.\n",
+		c, sequence);
+	return -1;
+}
+
+
+IsotopicPatternPointer finishPeptide(IsotopicPatternPointer *IPCollection,
+	IsotopicPatternPointer peptide){
+
 	/*compensate for missing water at peptide ends*/
 	IsotopicPatternPointer temp =
 			combineIsotopicPatterns(peptide, IPCollection[0]);
@@ -481,4 +885,3 @@ IsotopicPatternPointer makePeptide(
 	
 	return peptide;
 }
-
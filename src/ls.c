@@ -17,141 +17,375 @@
  * Version 1.00 (Aug 22, 2013)                                              
  *                                                                           
  * Functions and structs for alinging retention times based on a linear 
- *     function whose parameters are determined by linear least squares. File
- *     depends heavily on MPFIT: A MINPACK-1 Least Squares Fitting Library in
- *     C.                                                         
+ *     function whose parameters are determined by linear least squares,     
+ *     solved in closed form and optionally reweighted against outliers.     
  *                                                                           
  * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
  */
 
 #include "ls.h"
-#include "common.h" //new2Darray
-#include "global.h" //alignWindow
+#include "global.h" //alignWindow, alignModel
+#include "common.h" //selectRank
+#include "pool.h" //poolFor, poolScratch
 
-#include "mpfit.h" //mpfit
+#include <stdlib.h> //malloc, free, exit
+#include <stdio.h> //fprintf
+#include <math.h> //fabs, ceil
 
-#include <stdlib.h> //malloc, free
-#include <math.h> //fabs
+#define ROBUST_ITERATIONS 20 //most reweightings of a robust fit
+#define HUBER_K 1.345 //residual scales beyond which points are downweighted
+#define MAD_SCALE 1.4826 //scales a MAD to a normal standard deviation
+#define LOWESS_SPAN 0.3 //fraction of a run's points each local line is fit to
+#define LOWESS_ITERATIONS 2 //robustness reweightings of a lowess fit
+#define LOWESS_MIN_POINTS 20 //fewest points a lowess curve is fit to
+#define BISQUARE_SCALE 6 //residual MADs at which a point loses all weight
+#define FIT_SCRATCH 6 //doubles of worker scratch used per peptide in a fit
 
 /*
- * vars_struct - This is the private data structure which contains the data   
- *     points and their uncertainties. Stolen from testmpfit.c of MPFIT: A   
- *     MINPACK-1 Least Squares Fitting Library in C.    
+ * runFit - The rt table and medians the runs are fitted against, with the
+ *     parameters of every run, filled on the pool one run per index.
  */
-struct vars_struct {
-	double *x;
-	double *y;
-	double *ey;
-};
+typedef struct runFit {
+	MatrixPointer rt;
+	double *median;
+	int peptideCount;
+	MatrixPointer params;
+}RunFit, *RunFitPointer;
 
 /*
- * fit - Fit a linear function to the data. Based heavily on the func 
- *     testlinfit from testmpfit.c of MINPACK-1 Least Squares Fitting Library.
+ * fit - Fit y = p[0] - p[1]*x to the n points by weighted least squares in
+ *     closed form, every weight 1 if w is NULL. Return 0 on success, -1 if
+ *     there are fewer than two points or x does not vary, leaving p as is.
  */
-int fit(double *x, double *y, int n, double *p);
+int fit(double *x, double *y, double *w, int n, double *p);
 
 /*
- * linfunc - modified version of linfunc from testmpfit.c of MINPACK-1 Least    *
- *     Squares Fitting Library. 
+ * robustFit - Fit as fit does, then refit with Huber weights computed from
+ *     the residuals until the parameters settle. w holds n weights of
+ *     scratch and r n residuals. Return the status of the first fit.
  */
-int linfunc(int m, int n, double *p, double *dy, double **dvec, void *vars);
+int robustFit(double *x, double *y, double *w, double *r, int n, double *p);
+
+/*
+ * rtPoint - A median retention time and the run's retention time with it.
+ */
+typedef struct rtPoint {
+	double x;
+	double y;
+}RtPoint;
+
+/*
+ * comparePoints - qsort comparator ordering RtPoints by x, then y.
+ */
+int comparePoints(const void *a, const void *b);
+
+/*
+ * lowessFit - Fit a lowess curve to the n points, evaluated at up to
+ *     LOWESS_KNOTS knots spread evenly over the ranks of x. Each knot takes
+ *     the value of a line fit to the nearest LOWESS_SPAN of the points with
+ *     tricube weights, and the knots are refit LOWESS_ITERATIONS times with
+ *     bisquare weights against outliers. x and y are sorted in place and
+ *     scratch holds 3*n doubles. The knot count and knots are stored in p
+ *     after the linear parameters; the count is 0 when there are too few
+ *     points, in which case -1 is returned.
+ */
+int lowessFit(double *x, double *y, double *scratch, int n, double *p);
+
+/*
+ * predictRT - Return the retention time a run's parameters p map the median
+ *     retention time x to.
+ */
+double predictRT(double *p, double x);
+
+/*
+ * fitRun - Pool task fitting run index of a RunFit.
+ */
+void fitRun(void *ptr, int index, int worker);
 
 ///////////////////////////////////////////////////////////////////////////////
 //                       END OF FUNCTION DECLARATIONS                        //
 ///////////////////////////////////////////////////////////////////////////////
 
-int fit(double *x, double *y, int n, double *p){
- 	int i;
+int fit(double *x, double *y, double *w, int n, double *p){
+	int i;
+	if(n < 2){
+		return -1;
+	}
 
-	double *ey = (double *)malloc(n * sizeof(double));
-	for (i=0; i<n; i++){
-		ey[i] = 1;
-	}  
+	/*weighted means, then the centred sums of squares and products*/
+	double sw = 0;
+	double sx = 0;
+	double sy = 0;
+	for(i = 0; i < n; ++i){
+		double wi = w ? w[i] : 1;
+		sw += wi;
+		sx += wi * x[i];
+		sy += wi * y[i];
+	}
+	if(sw <= 0){
+		return -1;
+	}
+	double mx = sx / sw;
+	double my = sy / sw;
+	double sxx = 0;
+	double sxy = 0;
+	for(i = 0; i < n; ++i){
+		double wi = w ? w[i] : 1;
+		sxx += wi * (x[i] - mx) * (x[i] - mx);
+		sxy += wi * (x[i] - mx) * (y[i] - my);
+	}
+	if(sxx == 0){
+		return -1;
+	}
 
-	int status;
-	struct vars_struct v;
-	v.x = x;
-	v.y = y;
-	v.ey = ey;
+	/*note the fit is y = a - b*x*/
+	p[1] = -sxy / sxx;
+	p[0] = my + p[1] * mx;
+	return 0;
+}
 
-	/* Call fitting function for n data points */
-	status = mpfit(linfunc, n, 2, p, 0, 0, (void *) &v, 0);
- 	return status;
+
+int robustFit(double *x, double *y, double *w, double *r, int n, double *p){
+	int i, k;
+	int status = fit(x, y, NULL, n, p);
+	for(k = 0; status == 0 && k < ROBUST_ITERATIONS; ++k){
+		/*scale residuals by their median absolute value*/
+		for(i = 0; i < n; ++i){
+			r[i] = fabs(y[i] - (p[0] - p[1] * x[i]));
+			w[i] = r[i];
+		}
+		double scale = MAD_SCALE * selectRank(w, n, n / 2);
+		if(scale == 0){
+			break;
+		}
+		for(i = 0; i < n; ++i){
+			w[i] = r[i] <= HUBER_K * scale ? 1 : HUBER_K * scale / r[i];
+		}
+		double q[2] = {p[0], p[1]};
+		if(fit(x, y, w, n, q)){
+			break;
+		}
+		double shift = fabs(q[0] - p[0]) + fabs(q[1] - p[1]);
+		p[0] = q[0];
+		p[1] = q[1];
+		if(shift < 1e-9 * (1 + fabs(p[0]) + fabs(p[1]))){
+			break;
+		}
+	}
+	return status;
 }
 
 
-int linfunc(int m, int n, double *p, double *dy, double **dvec, void *vars){
-	int i;
-	struct vars_struct *v = (struct vars_struct *) vars;
-	double *x, *y, *ey, f;
+void fitRun(void *ptr, int index, int worker){
+	RunFitPointer rf = (RunFitPointer)ptr;
+	int j;
+	int peptideCount = rf->peptideCount;
+	double *p = matrixRow(rf->params, index);
+	p[0] = 1;
+	p[1] = 1;
 
-	x = v->x;
-	y = v->y;
-	ey = v->ey;
+	double *column = (double *)poolScratch(
+		FIT_SCRATCH * (peptideCount ? peptideCount : 1) * sizeof(double));
+	if(column == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot align runs!\n");
+		exit(1);
+	}
+	double *x = column + peptideCount;
+	double *y = x + peptideCount;
+	int n = 0;
+	/*Get run rt and median rt when run rt is not zero*/ 
+	matrixColumn(rf->rt, index, column);
+	for(j=0; j<peptideCount; ++j){
+		if(column[j] != 0 && rf->median[j] != 0
+				// 2014-07-16 added below
+				// check to align on well behaved peptides only
+				&& fabs(column[j] - rf->median[j]) < alignWindow){
+			y[n] = column[j];
+			x[n] = rf->median[j];
+			n++;
+		}
+	}
+	if(alignModel == ROBUST_ALIGN){
+		robustFit(x, y, y + peptideCount, y + 2 * peptideCount, n, p);
+	}else{
+		fit(x, y, NULL, n, p);
+	}
 
-	for (i=0; i<m; i++) {
-		f = p[0] - p[1]*x[i];     /* Linear fit function; note f = a - b*x */
-		dy[i] = (y[i] - f)/ey[i];
+	/*the line is kept to extend the curve past its last knots*/
+	if(alignModel == LOWESS_ALIGN){
+		lowessFit(x, y, y + peptideCount, n, p);
 	}
-  return 0;
+	return;
 }
 
 
-double **leastSquares(double **rt, double *median, int peptideCount,
-	int fileCount){
-	double **params = new2Darray(fileCount, 2);
-	int i,j;
-	for(i=0; i<fileCount; ++i){
-		double *x = (double*)malloc(peptideCount*sizeof(double) );
-		double *y = (double*)malloc(peptideCount*sizeof(double) );
-		for(j=0; j<2; ++j){
-			params[i][j] = 1;
-		}		
-		int n = 0;
-		/*Get run rt and median rt when run rt is not zero*/ 
-		for(j=0; j<peptideCount; ++j){
-			if(rt[j][i] != 0 && median[j] != 0
-					// 2014-07-16 added below
-					// check to align on well behaved peptides only
-					&& fabs(rt[j][i] - median[j]) < alignWindow){
-				y[n] = rt[j][i];
-				x[n] = median[j];
-				n++;
+int comparePoints(const void *a, const void *b){
+	const RtPoint *u = (const RtPoint *)a;
+	const RtPoint *v = (const RtPoint *)b;
+	if(u->x != v->x){
+		return (u->x > v->x) - (u->x < v->x);
+	}
+	return (u->y > v->y) - (u->y < v->y);
+}
+
+
+int lowessFit(double *x, double *y, double *scratch, int n, double *p){
+	int i, k, it;
+	double *knotX = p + 3;
+	double *knotY = knotX + LOWESS_KNOTS;
+	p[2] = 0;
+	if(n < LOWESS_MIN_POINTS){
+		return -1;
+	}
+
+	/*order the points by median rt, the only sort of the fit*/
+	RtPoint *points = (RtPoint *)scratch;
+	for(i = 0; i < n; ++i){
+		points[i].x = x[i];
+		points[i].y = y[i];
+	}
+	qsort(points, n, sizeof(RtPoint), comparePoints);
+	for(i = 0; i < n; ++i){
+		x[i] = points[i].x;
+		y[i] = points[i].y;
+	}
+	double *robust = scratch;
+	double *local = robust + n;
+	double *residual = local + n;
+
+	/*knots at evenly spaced ranks, skipping repeated medians*/
+	int count = 0;
+	for(k = 0; k < LOWESS_KNOTS; ++k){
+		int rank = (int)( (double)k * (n - 1) / (LOWESS_KNOTS - 1) + 0.5);
+		if(count == 0 || x[rank] > knotX[count-1]){
+			knotX[count++] = x[rank];
+		}
+	}
+	if(count < 2){
+		return -1;
+	}
+
+	int span = (int)ceil(LOWESS_SPAN * n);
+	for(i = 0; i < n; ++i){
+		robust[i] = 1;
+	}
+	for(it = 0; it <= LOWESS_ITERATIONS; ++it){
+		int lo = 0;
+		for(k = 0; k < count; ++k){
+			double x0 = knotX[k];
+
+			/*slide the window of the span points nearest the knot*/
+			while(lo + span < n && x[lo+span] - x0 < x0 - x[lo]){
+				++lo;
 			}
+			double reach = fmax(x0 - x[lo], x[lo+span-1] - x0);
+			double sw = 0;
+			double swy = 0;
+			for(i = 0; i < span; ++i){
+				double u = reach > 0 ? fabs(x[lo+i] - x0) / reach : 0;
+				double tricube = u < 1 ? 1 - u * u * u : 0;
+				local[i] = tricube * tricube * tricube * robust[lo+i];
+				sw += local[i];
+				swy += local[i] * y[lo+i];
+			}
+			double q[2];
+			if(fit(x + lo, y + lo, local, span, q) == 0){
+				knotY[k] = q[0] - q[1] * x0;
+			}else{
+				knotY[k] = sw > 0 ? swy / sw : y[lo + span/2];
+			}
+		}
+		p[2] = count;
+		if(it == LOWESS_ITERATIONS){
+			break;
+		}
+
+		/*bisquare weights from the residuals about the curve*/
+		for(i = 0; i < n; ++i){
+			residual[i] = fabs(y[i] - predictRT(p, x[i]));
+			local[i] = residual[i];
+		}
+		double scale = BISQUARE_SCALE * selectRank(local, n, n / 2);
+		if(scale == 0){
+			break;
+		}
+		for(i = 0; i < n; ++i){
+			double u = residual[i] / scale;
+			robust[i] = u < 1 ? (1 - u * u) * (1 - u * u) : 0;
+		}
+	}
+	return 0;
+}
+
+
+double predictRT(double *p, double x){
+	int count = alignModel == LOWESS_ALIGN ? (int)p[2] : 0;
+	if(count < 2){
+		return p[0] - p[1]*x;
+	}
+	double *knotX = p + 3;
+	double *knotY = knotX + LOWESS_KNOTS;
+
+	/*past the knots follow the slope of the line*/
+	if(x <= knotX[0]){
+		return knotY[0] - p[1]*(x - knotX[0]);
+	}
+	if(x >= knotX[count-1]){
+		return knotY[count-1] - p[1]*(x - knotX[count-1]);
+	}
+	int lo = 0;
+	int hi = count - 1;
+	while(hi - lo > 1){
+		int mid = (lo + hi) / 2;
+		if(knotX[mid] <= x){
+			lo = mid;
+		}else{
+			hi = mid;
 		}
-		fit(x, y, n, params[i]);
-		free(x);
-		free(y);
 	}
+	double t = (x - knotX[lo]) / (knotX[hi] - knotX[lo]);
+	return knotY[lo] + t * (knotY[hi] - knotY[lo]);
+}
+
+
+MatrixPointer leastSquares(MatrixPointer rt, double *median, int peptideCount,
+	int fileCount){
+	MatrixPointer params = newMatrix(fileCount,
+		alignModel == LOWESS_ALIGN ? LOWESS_PARAMS : 2);
+	if(params == NULL){
+		exit(1);
+	}
+	RunFit rf = {rt, median, peptideCount, params};
+	poolFor(fileCount, 1, fitRun, &rf);
 	return params;
 }
 
 
-void align(double **ms2rt, double **ms1rt, double *ms2median, 
-	double *ms1median, double **ms2params, double **ms1params,
+void align(MatrixPointer ms2rt, MatrixPointer ms1rt, double *ms2median, 
+	double *ms1median, MatrixPointer ms2params, MatrixPointer ms1params,
 	int peptideCount, int fileCount){
 
 	int i, j;	
 
 	for(i = 0; i < peptideCount; ++i){
+		double *ms2 = matrixRow(ms2rt, i);
+		double *ms1 = matrixRow(ms1rt, i);
 		for(j = 0; j < fileCount; ++j){
+			double *ms2p = matrixRow(ms2params, j);
+			double *ms1p = matrixRow(ms1params, j);
 			/*if there is no ms2 identification*/
-			if(ms2rt[i][j] == 0){
+			if(ms2[j] == 0){
 				/*if median ms1 and ms2 retention times are close*/
 				if(fabs(ms2median[i] - ms1median[i]) < alignWindow && 
 					ms1median[i] > 0){
 
-					ms2rt[i][j] = ms1params[j][0] - 
-						ms1params[j][1]*ms1median[i];
+					ms2[j] = predictRT(ms1p, ms1median[i]);
 				}else{
-					ms2rt[i][j] = ms2params[j][0] -
-						ms2params[j][1]*ms2median[i];
+					ms2[j] = predictRT(ms2p, ms2median[i]);
 				}
 			/*use ms1 over ms2 only if there are close*/
-			}else if(fabs(ms2rt[i][j] - ms1rt[i][j]) < alignWindow &&
-				ms1rt[i][j] > 0){
-
-				ms2rt[i][j] = ms1rt[i][j];
+			}else if(fabs(ms2[j] - ms1[j]) < alignWindow && ms1[j] > 0){
+				ms2[j] = ms1[j];
 			}
 		}
 	}
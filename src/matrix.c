@@ -0,0 +1,107 @@
+/*
+ * matrix.c                                                                  
+ * ========                                                                  
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Row major matrix of doubles kept in a single cache line aligned           
+ *     allocation, replacing tables of separately allocated rows.            
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#define _POSIX_C_SOURCE 200809L //posix_memalign
+
+#include "matrix.h"
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, posix_memalign, free
+#include <string.h> //memset, memmove
+
+#define CACHE_LINE 64 //bytes the allocation and wide rows are aligned to
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+MatrixPointer newMatrix(int rows, int cols){
+	MatrixPointer mp = (MatrixPointer)malloc(sizeof(Matrix));
+	if(mp == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create matrix!\n");
+		return NULL;
+	}
+	int perLine = CACHE_LINE / sizeof(double);
+	mp->rows = rows;
+	mp->cols = cols;
+
+	/*narrow rows are packed, padding them would multiply their memory*/
+	mp->stride = cols;
+	if(cols >= perLine){
+		mp->stride = (cols + perLine - 1) / perLine * perLine;
+	}
+	size_t size = (size_t)rows * mp->stride * sizeof(double);
+	void *data = NULL;
+	if(posix_memalign(&data, CACHE_LINE, size ? size : CACHE_LINE)){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create matrix!\n");
+		free(mp);
+		return NULL;
+	}
+	memset(data, 0, size);
+	mp->data = (double *)data;
+	return mp;
+}
+
+
+MatrixPointer delMatrix(MatrixPointer mp){
+	if(mp == NULL){
+		return NULL;
+	}
+	free(mp->data);
+	free(mp);
+	return NULL;
+}
+
+
+double *matrixRow(MatrixPointer mp, int row){
+	return mp->data + (size_t)row * mp->stride;
+}
+
+
+void matrixColumn(MatrixPointer mp, int column, double *values){
+	int i;
+	const double *value = mp->data + column;
+	for(i = 0; i < mp->rows; ++i){
+		values[i] = *value;
+		value += mp->stride;
+	}
+}
+
+
+int compactRows(MatrixPointer mp, const bool *keep){
+	int i;
+	int rows = 0;
+	size_t width = mp->stride * sizeof(double);
+	for(i = 0; i < mp->rows; ++i){
+		if(!keep[i]){
+			continue;
+		}
+		if(rows != i){
+			memmove(matrixRow(mp, rows), matrixRow(mp, i), width);
+		}
+		++rows;
+	}
+	mp->rows = rows;
+	return rows;
+}
@@ -422,7 +422,6 @@ int readMZXML(char *filename, MZXMLPointer *mzXML ){
 	}
  	
     xmlFreeDoc(doc); 
-	xmlCleanupParser();
 	malloc_trim(0);
 	
 	return status;
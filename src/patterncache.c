@@ -0,0 +1,344 @@
+/*
+ * patterncache.c                                                            
+ * ==============                                                            
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for sharing isotopic patterns between peptides with the same    
+ *     elemental composition. Patterns are spread over independently locked  
+ *     shards so that threads rarely wait on each other, and may be saved to 
+ *     and read from disk to be reused between runs.                         
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "patterncache.h"
+#include "global.h" //isotopicStates
+
+#include <stdio.h> //fprintf, fopen, fread, fwrite
+#include <stdlib.h> //malloc, calloc, free
+#include <string.h> //memcpy, memcmp, memset
+#include <stdint.h> //uint32_t
+
+#define SHARD_SIZE 64 //initial buckets of a shard
+#define PATTERN_MAGIC "PQI1"
+
+/*
+ * patternFile - Header of a pattern cache file.
+ */
+typedef struct patternFile {
+	char magic[4];
+	int isotopicStates;
+	int elementCount;
+	int count;
+} PatternFile;
+
+/*
+ * hashComposition - FNV-1a hash of an elemental composition.
+ */
+uint32_t hashComposition(int *composition);
+
+/*
+ * findEntry - Return the entry of the composition in the shard, NULL if it is
+ *     not cached. The shard must be locked.
+ */
+PatternEntryPointer findEntry(PatternShardPointer sp, int *composition,
+	uint32_t hash);
+
+/*
+ * insertEntry - Add the pattern to the shard unless the composition is already
+ *     cached, growing the shard as needed. The shard must be locked. Return 1
+ *     if the pattern was added.
+ */
+int insertEntry(PatternShardPointer sp, int *composition, float *intensity,
+	float *mass, uint32_t hash);
+
+/*
+ * growShard - Double the number of buckets of the shard and rehash its entries.
+ */
+void growShard(PatternShardPointer sp);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+PatternCachePointer newPatternCache(void){
+	PatternCachePointer pc = (PatternCachePointer)malloc(sizeof(PatternCache));
+	if(pc == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create cache!\n");
+		return NULL;
+	}
+	int i;
+	for(i = 0; i < CACHE_SHARDS; ++i){
+		pthread_mutex_init(&pc->shards[i].lock, NULL);
+		pc->shards[i].size = SHARD_SIZE;
+		pc->shards[i].count = 0;
+		pc->shards[i].buckets = (PatternEntryPointer *)calloc(SHARD_SIZE,
+			sizeof(PatternEntryPointer));
+		if(pc->shards[i].buckets == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot create cache!\n");
+			pc->shards[i].size = 0;
+		}
+	}
+	return pc;
+}
+
+
+PatternCachePointer delPatternCache(PatternCachePointer pc){
+	if(pc == NULL){
+		return NULL;
+	}
+	int i, j;
+	for(i = 0; i < CACHE_SHARDS; ++i){
+		PatternShardPointer sp = pc->shards + i;
+		for(j = 0; j < sp->size; ++j){
+			PatternEntryPointer pep = sp->buckets[j];
+			while(pep != NULL){
+				PatternEntryPointer next = pep->next;
+				free(pep->intensity);
+				free(pep->mass);
+				free(pep);
+				pep = next;
+			}
+		}
+		free(sp->buckets);
+		pthread_mutex_destroy(&sp->lock);
+	}
+	free(pc);
+	pc = NULL;
+	return pc;
+}
+
+
+IsotopicPatternPointer cachedComposition(PatternCachePointer pc,
+	int *composition){
+
+	uint32_t hash = hashComposition(composition);
+	PatternShardPointer sp = pc->shards + hash % CACHE_SHARDS;
+
+	IsotopicPatternPointer ipp = (IsotopicPatternPointer)malloc(
+		sizeof(IsotopicPattern));
+	if(ipp == NULL){
+		fprintf(stderr,
+			"\nERROR: Out of memory - cannot create isotopic pattern.\n");
+		return NULL;
+	}
+	ipp->intensity = (float *)malloc(isotopicStates * sizeof(float));
+	ipp->mass = (float *)malloc(isotopicStates * sizeof(float));
+	if(ipp->intensity == NULL || ipp->mass == NULL){
+		fprintf(stderr,
+			"\nERROR: Out of memory - cannot create isotopic pattern.\n");
+		return delIsotopicPattern(ipp);
+	}
+
+	pthread_mutex_lock(&sp->lock);
+	PatternEntryPointer pep = findEntry(sp, composition, hash);
+	if(pep != NULL){
+		memcpy(ipp->intensity, pep->intensity, isotopicStates * sizeof(float));
+		memcpy(ipp->mass, pep->mass, isotopicStates * sizeof(float));
+		pthread_mutex_unlock(&sp->lock);
+		return ipp;
+	}
+	pthread_mutex_unlock(&sp->lock);
+
+	/*compute outside the lock, a racing thread computes the same pattern*/
+	IsotopicPatternPointer computed = makeComposition(composition);
+	if(computed == NULL){
+		return delIsotopicPattern(ipp);
+	}
+	memcpy(ipp->intensity, computed->intensity, isotopicStates*sizeof(float));
+	memcpy(ipp->mass, computed->mass, isotopicStates * sizeof(float));
+
+	pthread_mutex_lock(&sp->lock);
+	if(insertEntry(sp, composition, computed->intensity, computed->mass,
+		hash)){
+		computed->intensity = NULL;
+		computed->mass = NULL;
+	}
+	pthread_mutex_unlock(&sp->lock);
+	delIsotopicPattern(computed);
+	return ipp;
+}
+
+
+int readPatternCache(PatternCachePointer pc, char *path){
+	FILE *fp = fopen(path, "rb");
+	if(fp == NULL){
+		return 0;
+	}
+
+	PatternFile header;
+	if(fread(&header, sizeof(PatternFile), 1, fp) != 1 ||
+		memcmp(header.magic, PATTERN_MAGIC, sizeof(header.magic)) ||
+		header.isotopicStates != isotopicStates ||
+		header.elementCount != ELEMENT_COUNT ||
+		header.count < 0){
+		fclose(fp);
+		return 0;
+	}
+
+	int i;
+	int read = 0;
+	for(i = 0; i < header.count; ++i){
+		int composition[ELEMENT_COUNT];
+		float *intensity = (float *)malloc(isotopicStates * sizeof(float));
+		float *mass = (float *)malloc(isotopicStates * sizeof(float));
+		if(intensity == NULL || mass == NULL ||
+			fread(composition, sizeof(int), ELEMENT_COUNT, fp) !=
+			ELEMENT_COUNT ||
+			(int)fread(intensity, sizeof(float), isotopicStates, fp) !=
+			isotopicStates ||
+			(int)fread(mass, sizeof(float), isotopicStates, fp) !=
+			isotopicStates){
+
+			free(intensity);
+			free(mass);
+			break;
+		}
+		uint32_t hash = hashComposition(composition);
+		PatternShardPointer sp = pc->shards + hash % CACHE_SHARDS;
+		pthread_mutex_lock(&sp->lock);
+		if(insertEntry(sp, composition, intensity, mass, hash)){
+			read++;
+		}else{
+			free(intensity);
+			free(mass);
+		}
+		pthread_mutex_unlock(&sp->lock);
+	}
+	fclose(fp);
+	return read;
+}
+
+
+void writePatternCache(PatternCachePointer pc, char *path){
+	FILE *fp = fopen(path, "wb");
+	if(fp == NULL){
+		fprintf(stderr, "\nWARNING: could not write pattern cache %s\n", path);
+		return;
+	}
+
+	int i, j;
+	PatternFile header;
+	memset(&header, 0, sizeof(PatternFile));
+	memcpy(header.magic, PATTERN_MAGIC, sizeof(header.magic));
+	header.isotopicStates = isotopicStates;
+	header.elementCount = ELEMENT_COUNT;
+	header.count = 0;
+	for(i = 0; i < CACHE_SHARDS; ++i){
+		header.count += pc->shards[i].count;
+	}
+
+	int failed = fwrite(&header, sizeof(PatternFile), 1, fp) != 1;
+	for(i = 0; i < CACHE_SHARDS && !failed; ++i){
+		PatternShardPointer sp = pc->shards + i;
+		for(j = 0; j < sp->size && !failed; ++j){
+			PatternEntryPointer pep;
+			for(pep = sp->buckets[j]; pep != NULL && !failed; pep = pep->next){
+				failed = fwrite(pep->composition, sizeof(int), ELEMENT_COUNT,
+					fp) != ELEMENT_COUNT ||
+					(int)fwrite(pep->intensity, sizeof(float), isotopicStates,
+					fp) != isotopicStates ||
+					(int)fwrite(pep->mass, sizeof(float), isotopicStates,
+					fp) != isotopicStates;
+			}
+		}
+	}
+	if(failed){
+		fprintf(stderr, "\nWARNING: could not write pattern cache %s\n", path);
+		fclose(fp);
+		remove(path);
+		return;
+	}
+	fclose(fp);
+	return;
+}
+
+
+uint32_t hashComposition(int *composition){
+	uint32_t hash = 2166136261u;
+	int i;
+	for(i = 0; i < ELEMENT_COUNT; ++i){
+		hash ^= (uint32_t)composition[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+PatternEntryPointer findEntry(PatternShardPointer sp, int *composition,
+	uint32_t hash){
+
+	if(sp->size == 0){
+		return NULL;
+	}
+	PatternEntryPointer pep = sp->buckets[(hash / CACHE_SHARDS) % sp->size];
+	while(pep != NULL && memcmp(pep->composition, composition,
+		ELEMENT_COUNT * sizeof(int))){
+		pep = pep->next;
+	}
+	return pep;
+}
+
+
+int insertEntry(PatternShardPointer sp, int *composition, float *intensity,
+	float *mass, uint32_t hash){
+
+	if(sp->size == 0 || findEntry(sp, composition, hash) != NULL){
+		return 0;
+	}
+	if(sp->count >= sp->size){
+		growShard(sp);
+	}
+	PatternEntryPointer pep = (PatternEntryPointer)malloc(sizeof(PatternEntry));
+	if(pep == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot cache pattern!\n");
+		return 0;
+	}
+	memcpy(pep->composition, composition, ELEMENT_COUNT * sizeof(int));
+	pep->intensity = intensity;
+	pep->mass = mass;
+	int bucket = (hash / CACHE_SHARDS) % sp->size;
+	pep->next = sp->buckets[bucket];
+	sp->buckets[bucket] = pep;
+	sp->count++;
+	return 1;
+}
+
+
+void growShard(PatternShardPointer sp){
+	int size = 2 * sp->size;
+	PatternEntryPointer *buckets = (PatternEntryPointer *)calloc(size,
+		sizeof(PatternEntryPointer));
+	if(buckets == NULL){
+		return; //keep the longer chains
+	}
+	int i;
+	for(i = 0; i < sp->size; ++i){
+		PatternEntryPointer pep = sp->buckets[i];
+		while(pep != NULL){
+			PatternEntryPointer next = pep->next;
+			int bucket = (hashComposition(pep->composition) / CACHE_SHARDS) %
+				size;
+			pep->next = buckets[bucket];
+			buckets[bucket] = pep;
+			pep = next;
+		}
+	}
+	free(sp->buckets);
+	sp->buckets = buckets;
+	sp->size = size;
+	return;
+}
@@ -29,11 +29,20 @@
 #include "pepxml.h"
 #include "ls.h"
 #include "global.h"
+#include "summary.h" //summaryApexRT, summaryIntensity
+#include "pool.h" //initPool, delPool, poolFor
+#include "isotope.h" //COMPOSITION_MODEL
+#include "graph.h" //newGraph, addStage, stageAfter, runGraph
+#include "mzXML.h" //MZXMLPointer, readMZXML, delMZXML
+#include "hits.h" //HitStorePointer, delHitStore
+#include "matrix.h" //MatrixPointer, newMatrix, matrixRow, compactRows
+
+#include <libxml/parser.h> //xmlInitParser, xmlCleanupParser
 
 #include <math.h>//fabs, NAN
 #include <stdlib.h> 
 #include <stdio.h> //printf
-#include <string.h> //strcmp
+#include <string.h> //strcmp, strcpy, memset
 #include <stdbool.h>
 
 int alignWindow = 90; //max discrepancy between MS1 and MS2 rt before defaulting
@@ -57,50 +66,142 @@ char *fuse = NULL; //parse fuse results (*.csv)
 int lys = 0; //SILAC label status 
 int arg = 0; //SILAC label status
 bool ignoreModSite = false; //ignore modifcation localization
+int chargeWindow = -1; //restrict ms1 search to observed charges +/- window,
+					   //negative to search all charges
+bool useFeatures = false; //search ms1 only where features match peptides
+bool recalibrate = false; //correct ms1 m/z error per file before searching
+bool streaming = false; //summarise ms1 hits per file rather than keep them
+int memBudget = 0; //MB that concurrently searched mzXMLs may use, 0 to search
+				   //one file at a time
+int isotopeModel = COMPOSITION_MODEL; //how peptide isotopic patterns are made
+int alignModel = LINEAR_ALIGN; //how run retention times are fit to medians
+char *isotopeCache = NULL; //path isotopic patterns are kept at between runs
 char **dataList = NULL; //a user requested list of data files to use
 size_t dataCount = 0; // the number of files in the user specified dataList
 
 
 /*
- * genMS2rtTable - generate a ms2 retention time table. The current 
- *     implementation uses the weighted centroid (average of retention times
- *     weighted by their respective intensities.
+ * pipeline - State handed between the stages of a run. Every field is
+ *     written by exactly one stage and only read by the stages after it.
  */
-void genMS2rtTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **ms2rt);
+typedef struct pipeline {
+	FastaPointer fasta;
+	PeptideStorePointer store;
+	PeptidePointer *peptides;
+	int peptideCount;
+	SpectraFileNodePointer filelist;
+	int fileCount;
+	HitStorePointer ms2hits; //identified ms2 scans by peptide row
+	HitStorePointer ms1hits; //ms1 search hits by peptide row
+	char *prefetchName; //first mzXML as named before isotopic patterns
+	MZXMLPointer prefetched;
+	MatrixPointer ms2rt;
+	MatrixPointer ms1rt;
+	double *ms1median;
+	double *ms2median;
+	MatrixPointer ms2params;
+	MatrixPointer ms1params;
+	MatrixPointer quantification;
+	MatrixPointer spectralCounts;
+	ProteinNodePointer pnp;
+	char **proteinMap;
+	int proteinCount;
+	MatrixPointer protQuant;
+	MatrixPointer protLQuant;
+	MatrixPointer protHQuant;
+	MatrixPointer protSpectralCounts;
+}Pipeline, *PipelinePointer;
+
+/* stageFasta - read the FASTA file */
+void stageFasta(void *ptr);
+
+/* stageParse - parse the search engine results into the peptide list */
+void stageParse(void *ptr);
+
+/* stagePrefetch - read the first mzXML while isotopic patterns are made */
+void stagePrefetch(void *ptr);
+
+/* stageIsotopes - generate isotopic patterns, dropping peptides without one */
+void stageIsotopes(void *ptr);
+
+/* stagePeptides - print the peptides and their isotopic patterns */
+void stagePeptides(void *ptr);
+
+/* stageFilelist - build the mzXML filelist used as table columns */
+void stageFilelist(void *ptr);
+
+/* stageSearch - search every mzXML for isotopic patterns */
+void stageSearch(void *ptr);
+
+/* stageResults - print the ms1 search results */
+void stageResults(void *ptr);
 
 /*
- * genMS1rtTable - generate a ms1 retention time table. The current 
- *     implementation uses the apical retention time (retention time with
- *     highest intensity).
+ * stageTables - calculate the ms2 and ms1 retention time and spectral count
+ *     tables in a single pass over the hits and print the rt tables
  */
-void genMS1rtTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **ms1rt);
+void stageTables(void *ptr);
+
+/* stageMedians - calculate and print median ms1 and ms2 retention times */
+void stageMedians(void *ptr);
+
+/* stageMS2params - determine the ms2 retention time calibration */
+void stageMS2params(void *ptr);
+
+/* stageMS1params - determine the ms1 retention time calibration */
+void stageMS1params(void *ptr);
 
 /*
- * medianRTtimes - given both ms1 and ms2 retention time tables create vectors
- *     of median retention time for each, where the median is determined over
- *     all non-zero values. 
+ * stageAlign - print the calibrations, align retention times, drop peptides
+ *     without a median retention time and print the aligned table.
  */
-void medianRTtimes(double *ms1median, double *ms2median, double **ms1rt,	
-	double **ms2rt, int peptideCount, int fileCount, PeptidePointer *peptides);
+void stageAlign(void *ptr);
+
+/* stageQuant - calculate the peptide intensity table */
+void stageQuant(void *ptr);
+
+/* stageProteins - convert peptide tables to the protein level */
+void stageProteins(void *ptr);
+
+/* stagePepTables - print peptide intensities and spectral counts */
+void stagePepTables(void *ptr);
+
+/* stageProtTables - print protein intensities, counts and H/L ratios */
+void stageProtTables(void *ptr);
+
+/* stageCoverage - print protein sequence coverage */
+void stageCoverage(void *ptr);
 
 /*
- * quant - given a retention time table, an array of peptides, and a
- *     linked list of files, create a quantity entry for every peptide, file
- *     tuple and store the value in the quantification table. 
+ * tableRow - Pool task filling row index of the ms2 and ms1 retention time
+ *     tables and the spectral count table from a single visit of the
+ *     peptide's hits. The ms2 rt is the weighted centroid (average of
+ *     retention times weighted by their respective intensities), the ms1 rt
+ *     the apical retention time (retention time with highest intensity) when
+ *     another hit within peakWindow supports it.
  */
-void quant(double **ms2rt, double **quantification, PeptidePointer *peptides,
-	int peptideCount, SpectraFileNodePointer filelist);
+void tableRow(void *ptr, int index, int worker);
 
 /*
- * countSpectra - create a table of ms2 spectral counts at the peptide level. 
- *     Current implementation uses a table of double to easily integrate with
- *     existing function for converting peptide level quantification results to
- *     the protein level.
+ * medianRow - Pool task taking the median ms1 and ms2 retention times of
+ *     peptide index over its non-zero values in the rt tables.
  */
-void countSpectra(PeptidePointer *peptides, int peptideCount,
-	SpectraFileNodePointer filelist, double **spectralCounts);
+void medianRow(void *ptr, int index, int worker);
+
+/*
+ * printMedians - print the median ms1 and ms2 retention time of every
+ *     peptide to median.txt
+ */
+void printMedians(double *ms1median, double *ms2median, int peptideCount,
+	PeptidePointer *peptides);
+
+/*
+ * quantRow - Pool task filling row index of the quantification table with
+ *     the intensity of the peptide's ms1 hits within quantWindow of its
+ *     aligned retention time, counting only hits whose isotopic pattern
+ *     correlates with the theoretical one.
+ */
+void quantRow(void *ptr, int index, int worker);
 
 ///////////////////////////////////////////////////////////////////////////////
 //                       END OF FUNCTION DECLARATIONS                        //
@@ -110,90 +211,284 @@ int main(int argc, char *argv[]){
 
 	parseArgs(argc, argv);
 
-	/*read FASTA file*/
+	/*start the worker threads shared by every multi-threaded step*/
+	if(initPool(threadCount)){
+		exit(EXIT_FAILURE);
+	}
+	/*files may be parsed from several threads at once, so libxml is set up
+	once here rather than around each file*/
+	xmlInitParser();
+
+	Pipeline pipeline;
+	memset(&pipeline, 0, sizeof(Pipeline));
+	PipelinePointer pl = &pipeline;
+
+	/*stages only wait on the stages whose results they consume*/
+	GraphPointer gp = newGraph();
+	if(gp == NULL){
+		exit(EXIT_FAILURE);
+	}
+	StagePointer fasta = addStage(gp, "fasta", stageFasta, pl);
+	StagePointer parse = addStage(gp, "parse", stageParse, pl);
+	StagePointer prefetch = addStage(gp, "prefetch", stagePrefetch, pl);
+	StagePointer isotopes = addStage(gp, "isotopes", stageIsotopes, pl);
+	StagePointer peptides = addStage(gp, "peptides", stagePeptides, pl);
+	StagePointer filelist = addStage(gp, "filelist", stageFilelist, pl);
+	StagePointer search = addStage(gp, "search", stageSearch, pl);
+	StagePointer results = addStage(gp, "results", stageResults, pl);
+	StagePointer tables = addStage(gp, "tables", stageTables, pl);
+	StagePointer medians = addStage(gp, "medians", stageMedians, pl);
+	StagePointer ms2params = addStage(gp, "ms2params", stageMS2params, pl);
+	StagePointer ms1params = addStage(gp, "ms1params", stageMS1params, pl);
+	StagePointer align = addStage(gp, "align", stageAlign, pl);
+	StagePointer quantify = addStage(gp, "quant", stageQuant, pl);
+	StagePointer proteins = addStage(gp, "proteins", stageProteins, pl);
+	StagePointer pepTables = addStage(gp, "pepTables", stagePepTables, pl);
+	StagePointer protTables = addStage(gp, "protTables", stageProtTables, pl);
+	StagePointer coverage = addStage(gp, "coverage", stageCoverage, pl);
+
+	stageAfter(prefetch, parse);
+	stageAfter(isotopes, parse);
+	stageAfter(peptides, isotopes);
+	stageAfter(filelist, isotopes);
+	stageAfter(search, filelist);
+	stageAfter(search, prefetch);
+	stageAfter(results, search);
+	stageAfter(tables, search);
+	stageAfter(medians, tables);
+	stageAfter(ms2params, medians);
+	stageAfter(ms1params, medians);
+	stageAfter(align, ms2params);
+	stageAfter(align, ms1params);
+	stageAfter(align, results);
+	stageAfter(align, peptides);
+	stageAfter(quantify, align);
+	stageAfter(proteins, quantify);
+	stageAfter(proteins, fasta);
+	stageAfter(pepTables, proteins);
+	stageAfter(protTables, proteins);
+	stageAfter(coverage, proteins);
+
+	runGraph(gp);
+	gp = delGraph(gp);
+	
+	/*Cleanup*/
+	printf("Cleaning up.\n");
+	pl->proteinMap = delProteinMap(pl->proteinMap, pl->peptideCount);
+	free(pl->peptides);
+	pl->store = delPeptideStore(pl->store);
+	pl->pnp = delProteinList(pl->pnp);
+	pl->filelist =  delSpectraFileList(pl->filelist);
+	pl->ms2hits = delHitStore(pl->ms2hits);
+	pl->ms1hits = delHitStore(pl->ms1hits);
+	delFasta(pl->fasta);
+	free(pl->prefetchName);
+	pl->ms2rt = delMatrix(pl->ms2rt);
+	pl->ms1rt = delMatrix(pl->ms1rt);
+	pl->quantification = delMatrix(pl->quantification);
+	pl->spectralCounts = delMatrix(pl->spectralCounts);
+	pl->protQuant = delMatrix(pl->protQuant);
+	pl->protLQuant = delMatrix(pl->protLQuant);
+	pl->protHQuant = delMatrix(pl->protHQuant);
+	pl->protSpectralCounts = delMatrix(pl->protSpectralCounts);
+	free(pl->ms2median);
+	free(pl->ms1median);
+	pl->ms2params = delMatrix(pl->ms2params);
+	pl->ms1params = delMatrix(pl->ms1params);
+	xmlCleanupParser();
+	delPool();
+
+	return 0;
+}
+
+
+void stageFasta(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Reading fasta %s\n", fastaName);
-	FastaPointer fasta;
-	readFASTA(fastaName, &fasta );
+	readFASTA(fastaName, &pl->fasta);
+	return;
+}
+
+
+void stageParse(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 
 	/*parse input file(s) and init peptide list*/
-	PeptidePointer pp = &TNILL;
+	pl->store = newPeptideStore();
+	if(pl->store == NULL){
+		exit(EXIT_FAILURE);
+	}
 	if(maxQuant){
 		printf("Parsing MaxQuant file.\n");
-		pp = parseMaxQuant(maxQuant, pp);
+		pl->store = parseMaxQuant(maxQuant, pl->store);
 	}else if(pepXMLdir){
 		printf("Parsing pepXML directory.\n");
-		pp = parsePepXMLdir(pepXMLdir);
+		pl->store = parsePepXMLdir(pepXMLdir, pl->store);
 	}else if(statQuestdir){
 		printf("Parsing statQuest directory.\n");
-		pp = parseStatQuestdir(statQuestdir, statQuestcutoff);
+		pl->store = parseStatQuestdir(statQuestdir, statQuestcutoff,
+			pl->store);
 	}else if(fuse){
 		printf("Parsing fuse results.\n");
-		pp = parseFuse(fuse, pp);
+		pl->store = parseFuse(fuse, pl->store);
 	}else{
 		fprintf(stderr, "\nERROR: no input file(s) specified!\n");
 		exit(EXIT_FAILURE);
 	}
 
-	/*get peptides list and generate isotopic patterns*/
-	int peptideCount = getCount(pp);
-	printf("\tFound %d peptides!\n", peptideCount);
-	PeptidePointer *peptides =  inOrder(pp, peptideCount);
+	pl->peptideCount = getCount(pl->store);
+	printf("\tFound %d peptides!\n", pl->peptideCount);
+	pl->peptides =  inOrder(pl->store, pl->peptideCount);
+
+	/*the first file is known before isotopic patterns settle the filelist*/
+	SpectraFileNodePointer first = newFilelist(pl->store, pl->peptides,
+		pl->peptideCount);
+	if(first != NULL){
+		pl->prefetchName = (char *)malloc( (strlen(first->rawFile)+1) *
+			sizeof(char) );
+		if(pl->prefetchName != NULL){
+			strcpy(pl->prefetchName, first->rawFile);
+		}
+	}
+	first = delSpectraFileList(first);
+	return;
+}
+
+
+void stagePrefetch(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	if(pl->prefetchName == NULL){
+		return;
+	}
+	printf("Prefetching %s\n", pl->prefetchName);
+	readMZXML(pl->prefetchName, &pl->prefetched);
+	return;
+}
+
+
+void stageIsotopes(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Generating isotopic patterns.\n");
-	pp = initIsotopicPatterns(pp, peptides, peptideCount);
-	peptideCount = getCount(pp);
-	printf("\tGenerated %d isotopic patterns!\n", peptideCount);
-	free(peptides); //memory will be reallocated if inOrder is called again
-	peptides =  inOrder(pp, peptideCount);
+	initIsotopicPatterns(pl->store, pl->peptides, pl->peptideCount);
+	pl->peptideCount = getCount(pl->store);
+	printf("\tGenerated %d isotopic patterns!\n", pl->peptideCount);
+	free(pl->peptides); //memory will be reallocated if inOrder is called again
+	pl->peptides =  inOrder(pl->store, pl->peptideCount);
+	return;
+}
 
-	printPeptides(peptides, peptideCount);
 
-	/*get mzXML filelist*/
+void stagePeptides(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	printPeptides(pl->peptides, pl->peptideCount);
+	return;
+}
+
+
+void stageFilelist(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Generating mzXML filelist.\n");
-	SpectraFileNodePointer filelist = NULL;
-	int fileCount = initFilelist(&filelist, peptides, peptideCount);
+	pl->fileCount = initFilelist(&pl->filelist, pl->store,
+		pl->peptides, pl->peptideCount);
+	int *columns = fileColumns(pl->store->files, pl->filelist);
+	if(columns == NULL){
+		exit(EXIT_FAILURE);
+	}
+	pl->ms2hits = psmHits(pl->store, columns, pl->peptideCount);
+	free(columns);
+	if(pl->ms2hits == NULL){
+		exit(EXIT_FAILURE);
+	}
+	return;
+}
+
+
+void stageSearch(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
+
+	/*peptides dropped by isotopic patterns may have removed the first file*/
+	if(pl->prefetched != NULL && (pl->filelist == NULL ||
+		strcmp(pl->filelist->rawFile, pl->prefetchName) ) ){
+
+		pl->prefetched = delMZXML(pl->prefetched);
+	}
 
-	/*search mzXMLs for isotopic patterns*/
 	printf("Searching ms1 spectra:\n");	
-	searchMzXMLs(peptides, peptideCount, filelist);
-	
-	/*print results*/
+	pl->ms1hits = searchMzXMLs(pl->ms2hits, pl->peptides, pl->peptideCount,
+		pl->filelist, pl->prefetched);
+	pl->prefetched = NULL;
+	if(pl->ms1hits == NULL){
+		exit(EXIT_FAILURE);
+	}
+	return;
+}
+
+
+void stageResults(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Printing search results.\n");
-	printSearchResults(peptides, peptideCount);
-
-	/*calculate ms2 table*/
-	printf("Calculating ms2 rt table\n");
-	double **ms2rt = new2Darray(peptideCount, fileCount);
-	genMS2rtTable(peptides, filelist, peptideCount, fileCount, ms2rt);
-		
-	/*print ms2 retention time table*/
-	printf("Printing ms2 rt table.\n");
-	printTable(peptides, filelist, peptideCount, fileCount, ms2rt, "ms2rt.txt");
+	printSearchResults(pl->peptides, pl->peptideCount, pl->filelist,
+		pl->ms2hits, pl->ms1hits);
+	return;
+}
 
-	/*calculate ms1 table*/
-	printf("Calculating ms1 rt table\n");
-	double **ms1rt = new2Darray(peptideCount, fileCount);
-	genMS1rtTable(peptides, filelist, peptideCount, fileCount, ms1rt);
 
-	/*print ms1 retention time table*/
+void stageTables(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	printf("Calculating rt and spectral count tables\n");
+	pl->ms2rt = newMatrix(pl->peptideCount, pl->fileCount);
+	pl->ms1rt = newMatrix(pl->peptideCount, pl->fileCount);
+	pl->spectralCounts = newMatrix(pl->peptideCount, pl->fileCount);
+	if(pl->ms2rt == NULL || pl->ms1rt == NULL || pl->spectralCounts == NULL){
+		exit(EXIT_FAILURE);
+	}
+	poolFor(pl->peptideCount, 0, tableRow, pl);
+	printf("Printing ms2 rt table.\n");
+	printTable(pl->peptides, pl->filelist, pl->peptideCount, pl->fileCount,
+		pl->ms2rt, "ms2rt.txt");
 	printf("Printing ms1 rt table.\n");
-	printTable(peptides, filelist, peptideCount, fileCount, ms1rt, "ms1rt.txt");
-	
-	/*calculate and print median ms1 and ms2 retention times*/
+	printTable(pl->peptides, pl->filelist, pl->peptideCount, pl->fileCount,
+		pl->ms1rt, "ms1rt.txt");
+	return;
+}
+
+
+void stageMedians(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Calculating median retention times.\n");
-	double *ms1median = (double *)malloc(peptideCount * sizeof(double) );
-	double *ms2median = (double *)malloc(peptideCount * sizeof(double) );
-	medianRTtimes(ms1median, ms2median, ms1rt, ms2rt, peptideCount, fileCount,
-		peptides);
+	pl->ms1median = (double *)malloc(pl->peptideCount * sizeof(double) );
+	pl->ms2median = (double *)malloc(pl->peptideCount * sizeof(double) );
+	if(pl->ms1median == NULL || pl->ms2median == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot take medians!\n");
+		exit(EXIT_FAILURE);
+	}
+	poolFor(pl->peptideCount, 0, medianRow, pl);
+	printMedians(pl->ms1median, pl->ms2median, pl->peptideCount,
+		pl->peptides);
+	return;
+}
+
 
-	/*determine ms2 retention time calibration*/
+void stageMS2params(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Determining ms2 retention time calibration.\n");
-	double **ms2params = 
-		leastSquares(ms2rt, ms2median, peptideCount, fileCount);
+	pl->ms2params = leastSquares(pl->ms2rt, pl->ms2median, pl->peptideCount,
+		pl->fileCount);
+	return;
+}
+
 
-	/*determine ms1 retention time calibration*/
+void stageMS1params(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Determining ms1 retention time calibration.\n");
-	double **ms1params = 
-		leastSquares(ms1rt, ms1median, peptideCount, fileCount);
+	pl->ms1params = leastSquares(pl->ms1rt, pl->ms1median, pl->peptideCount,
+		pl->fileCount);
+	return;
+}
+
+
+void stageAlign(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 
 	/*print alignment parameters*/
 	FILE *fp = fopen("ms2params.txt", "w");
@@ -205,12 +500,12 @@ int main(int argc, char *argv[]){
    		fprintf(stderr, "Error opening file: %s !\n", "ms1params.txt");
 	}
 	int i;
-	SpectraFileNodePointer root = filelist;
-	for(i=0; i<fileCount; ++i){
-		fprintf(fp, "%s\t%.4e\t%.4e\n", root->rawFile, 
-			ms2params[i][0], ms2params[i][1]);
-		fprintf(fp2, "%s\t%.4e\t%.4e\n", root->rawFile, 
-			ms1params[i][0], ms1params[i][1]);
+	SpectraFileNodePointer root = pl->filelist;
+	for(i=0; i<pl->fileCount; ++i){
+		double *ms2p = matrixRow(pl->ms2params, i);
+		double *ms1p = matrixRow(pl->ms1params, i);
+		fprintf(fp, "%s\t%.4e\t%.4e\n", root->rawFile, ms2p[0], ms2p[1]);
+		fprintf(fp2, "%s\t%.4e\t%.4e\n", root->rawFile, ms1p[0], ms1p[1]);
 		root = root->next;	
 	}
 	fclose(fp);
@@ -218,204 +513,202 @@ int main(int argc, char *argv[]){
 
 	/*align*/
 	printf("Aligning.\n");
-	align(ms2rt, ms1rt, ms2median, ms1median, ms2params, ms1params,
-		peptideCount, fileCount);
+	align(pl->ms2rt, pl->ms1rt, pl->ms2median, pl->ms1median, pl->ms2params,
+		pl->ms1params, pl->peptideCount, pl->fileCount);
 	
-	/*correct for 0 median ms1 and ms2 RT*/
+	/*correct for 0 median ms1 and ms2 RT, keeping the survivors in order*/
 	int rem_count = 0;
-	i = 0;
-	for(i=0; i < peptideCount; ++i ) {
-		if (ms1median[i] == 0 && ms2median[i] == 0){
-			free(ms2rt[i-rem_count]);
-			ms2rt[i-rem_count] = ms2rt[peptideCount-1];
-			ms2rt[peptideCount-1] = NULL;
-			free(peptides[i-rem_count]);
-			peptides[i-rem_count]= peptides[peptideCount-1];
-			peptides[peptideCount-1] = NULL;
-			--peptideCount;
+	int peptideCount = 0;
+	double *ms1median = pl->ms1median;
+	double *ms2median = pl->ms2median;
+	PeptidePointer *peptides = pl->peptides;
+	bool *keep = (bool *)malloc((pl->peptideCount ? pl->peptideCount : 1) *
+		sizeof(bool));
+	if(keep == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot align runs!\n");
+		exit(EXIT_FAILURE);
+	}
+	for(i=0; i < pl->peptideCount; ++i ) {
+		keep[i] = !(ms1median[i] == 0 && ms2median[i] == 0);
+	}
+	compactRows(pl->ms2rt, keep);
+	compactRows(pl->ms1rt, keep);
+	compactRows(pl->spectralCounts, keep);
+	for(i=0; i < pl->peptideCount; ++i ) {
+		if (!keep[i]){
+			removePeptide(pl->store, peptides[i]);
 			++rem_count;
+		}else{
+			ms1median[peptideCount] = ms1median[i];
+			ms2median[peptideCount] = ms2median[i];
+			peptides[peptideCount] = peptides[i];
+			++peptideCount;
 		}
 	}
+	free(keep);
+	pl->peptideCount = peptideCount;
 	printf("Removed %d peptides for 0 median ms1 and ms2 RTs", rem_count);
 
 	/*print callibrated rt table*/
 	printf("Printing aligned rt table.\n");
-	printTable(peptides, filelist, peptideCount, fileCount, ms2rt, "rt.txt");
+	printTable(pl->peptides, pl->filelist, pl->peptideCount, pl->fileCount,
+		pl->ms2rt, "rt.txt");
+	return;
+}
+
 
-	/*calculate intensities*/
+void stageQuant(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Calculating intensities.\n");
-	double **quantification = new2Darray(peptideCount, fileCount);
-	quant(ms2rt, quantification, peptides, peptideCount, filelist);
+	pl->quantification = newMatrix(pl->peptideCount, pl->fileCount);
+	if(pl->quantification == NULL){
+		exit(EXIT_FAILURE);
+	}
+	poolFor(pl->peptideCount, 0, quantRow, pl);
+	return;
+}
 
-	/*determine spectral counts table*/
-	double **spectralCounts = new2Darray(peptideCount, fileCount);
-	countSpectra(peptides, peptideCount, filelist, spectralCounts);
 
-	/*convert protein information to proteins*/
+void stageProteins(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Converting peptide information to protein level.\n");
-	ProteinNodePointer pnp = NULL;
-
-	char **proteinMap = NULL;
-	int proteinCount = pep2prot(&pnp, fasta, peptides, quantification,
-		spectralCounts, peptideCount, fileCount, &proteinMap);
-	double **protQuant = new2Darray(proteinCount, fileCount);
-	double **protLQuant = new2Darray(proteinCount, fileCount);
-	double **protHQuant = new2Darray(proteinCount, fileCount);
-	double **protSpectralCounts = new2Darray(proteinCount, fileCount);
-	prot2table(pnp, &protQuant, &protHQuant, &protLQuant, &protSpectralCounts,
-		proteinCount, fileCount);
-
-	/*print quantitation results*/
+	pl->proteinCount = pep2prot(&pl->pnp, pl->fasta, pl->peptides,
+		pl->quantification, pl->spectralCounts, pl->peptideCount,
+		pl->fileCount, &pl->proteinMap);
+	pl->protQuant = newMatrix(pl->proteinCount, pl->fileCount);
+	pl->protLQuant = newMatrix(pl->proteinCount, pl->fileCount);
+	pl->protHQuant = newMatrix(pl->proteinCount, pl->fileCount);
+	pl->protSpectralCounts = newMatrix(pl->proteinCount, pl->fileCount);
+	if(pl->protQuant == NULL || pl->protLQuant == NULL ||
+		pl->protHQuant == NULL || pl->protSpectralCounts == NULL){
+		exit(EXIT_FAILURE);
+	}
+	prot2table(pl->pnp, pl->protQuant, pl->protHQuant, pl->protLQuant,
+		pl->protSpectralCounts, pl->proteinCount, pl->fileCount);
+	return;
+}
+
+
+void stagePepTables(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Printing intensities and spectral counts.\n");
-	printPepTable(peptides, filelist, peptideCount, fileCount, quantification,
-		"quant.txt", proteinMap);
-	printPepTable(peptides, filelist, peptideCount, fileCount, spectralCounts,
-		"pepSpectra.txt", proteinMap);
+	printPepTable(pl->peptides, pl->filelist, pl->peptideCount, pl->fileCount,
+		pl->quantification, "quant.txt", pl->proteinMap);
+	printPepTable(pl->peptides, pl->filelist, pl->peptideCount, pl->fileCount,
+		pl->spectralCounts, "pepSpectra.txt", pl->proteinMap);
+	return;
+}
 
-	/*print protein quantitation results*/
+
+void stageProtTables(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
 	printf("Printing protein intensities.\n");
-	printProtTable(pnp, filelist, proteinCount, fileCount, protQuant,
-		"protQuant.txt");
-	printProtTable(pnp, filelist, proteinCount, fileCount, protHQuant,
-		"protHQuant.txt");
-	printProtTable(pnp, filelist, proteinCount, fileCount, protLQuant,
-		"protLQuant.txt");
-	printProtTable(pnp, filelist, proteinCount, fileCount, protSpectralCounts,
-		"protSpectra.txt");
+	printProtTable(pl->pnp, pl->filelist, pl->proteinCount, pl->fileCount,
+		pl->protQuant, "protQuant.txt");
+	printProtTable(pl->pnp, pl->filelist, pl->proteinCount, pl->fileCount,
+		pl->protHQuant, "protHQuant.txt");
+	printProtTable(pl->pnp, pl->filelist, pl->proteinCount, pl->fileCount,
+		pl->protLQuant, "protLQuant.txt");
+	printProtTable(pl->pnp, pl->filelist, pl->proteinCount, pl->fileCount,
+		pl->protSpectralCounts, "protSpectra.txt");
 
 	/* save some mem and determine H/L table in place */
-	int j;
-	for(i = 0; i < proteinCount; ++i){
-		for(j = 0; j < fileCount; ++j){
-			protHQuant[i][j] = (protLQuant[i][j] == 0)? NAN :
-				protHQuant[i][j]/protLQuant[i][j];
+	int i, j;
+	for(i = 0; i < pl->proteinCount; ++i){
+		double *heavy = matrixRow(pl->protHQuant, i);
+		double *light = matrixRow(pl->protLQuant, i);
+		for(j = 0; j < pl->fileCount; ++j){
+			heavy[j] = (light[j] == 0)? NAN : heavy[j]/light[j];
 		}
 	}
-	printProtTable(pnp, filelist, proteinCount, fileCount, protHQuant,
-		"protHLratio.txt");
+	printProtTable(pl->pnp, pl->filelist, pl->proteinCount, pl->fileCount,
+		pl->protHQuant, "protHLratio.txt");
+	return;
+}
 
-	printCoverage(fasta);
-	
-	/*Cleanup*/
-	printf("Cleaning up.\n");
-	proteinMap = delProteinMap(proteinMap, peptideCount);
-	free(peptides);
-	pp = delPeptideList(pp);
-	pnp = delProteinList(pnp);
-	filelist =  delSpectraFileList(filelist);
-	delFasta(fasta);
-	del2Darray(ms2rt, peptideCount);
-	del2Darray(ms1rt, peptideCount);
-	del2Darray(quantification, peptideCount);
-	del2Darray(spectralCounts, peptideCount);
-	del2Darray(protQuant, proteinCount);
-	del2Darray(protLQuant, proteinCount);
-	del2Darray(protHQuant, proteinCount);
-	del2Darray(protSpectralCounts, proteinCount);
-	free(ms2median);
-	free(ms1median);
 
-	return 0;
+void stageCoverage(void *ptr){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	printCoverage(pl->fasta);
+	return;
 }
 
 
-void genMS2rtTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **ms2rt){
+void tableRow(void *ptr, int index, int worker){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	PeptidePointer pp = pl->peptides[index];
+	HitStorePointer hits = pl->ms2hits;
+	double *ms2rt = matrixRow(pl->ms2rt, index);
+	double *ms1rt = matrixRow(pl->ms1rt, index);
+	double *spectralCounts = matrixRow(pl->spectralCounts, index);
+	int j, u, h;
+
+	/*ms2 centroids and spectral counts share the identified scans*/
+	int row = pp->row;
+	for(u = hits->runStart[row]; u < hits->runStart[row+1]; ++u){
+		j = hits->runColumn[u];
+		double totalIntensity = 0;
+		double weightedCentroid = 0;
+		for(h = hits->hitStart[u]; h < hits->hitStart[u+1]; ++h){
+			totalIntensity+=hits->intensity[h];
+		}
+		for(h = hits->hitStart[u]; h < hits->hitStart[u+1]; ++h){
+			weightedCentroid+=
+				(hits->intensity[h]*hits->rt[h])/totalIntensity;
+		}
+		ms2rt[j] = weightedCentroid;
+		spectralCounts[j] = hits->hitStart[u+1] - hits->hitStart[u];
+	}
 
-	int i;
-	int j = 0;
-	SpectraFileNodePointer rootFilelist = filelist;
-	for(i = 0; i < peptideCount; ++i){
-		filelist = rootFilelist;
-		j = 0;
-		while(filelist != NULL){
-			SpectraFileNodePointer sfnp = peptides[i]->spectraFiles;
+	if(pp->ms1Summaries != NULL){
+		for(j = 0; j < pl->fileCount; ++j){
+			ms1rt[j] = summaryApexRT(pp->ms1Summaries + j);
+		}
+		return;
+	}
+	hits = pl->ms1hits;
+	int width = hits->width;
+	for(u = hits->runStart[row]; u < hits->runStart[row+1]; ++u){
+		j = hits->runColumn[u];
+		double maxIntensity = 0;
+		double maxRT = 0;
+		int valid = 0;
+		for(h = hits->hitStart[u]; h < hits->hitStart[u+1]; ++h){
+			int k;
 			double totalIntensity = 0;
-			double weightedCentroid = 0;
-			while(sfnp != NULL){	
-				if(!strcmp(sfnp->rawFile, filelist->rawFile) ){
-					ScanNodePointer snp = sfnp->scans;
-					while(snp != NULL){
-						totalIntensity+=snp->intensity[0];
-						snp = snp->next;
-					}
-					snp = sfnp->scans;
-					while(snp != NULL){
-						weightedCentroid+=
-							(snp->intensity[0]*snp->rt)/totalIntensity;
-						snp = snp->next;
-					}
-				}
-				sfnp = sfnp->next;
+			for(k = 0; k < width; ++k){
+				totalIntensity+=hits->intensity[h*width + k];
+			}
+			if(totalIntensity > maxIntensity){
+				maxIntensity = totalIntensity;
+				maxRT = hits->rt[h];
+			}
+		}
+		for(h = hits->hitStart[u]; h < hits->hitStart[u+1]; ++h){
+			if(fabs(hits->rt[h] - maxRT) < 
+				peakWindow && hits->rt[h] != maxRT){
+
+				valid = 1;
 			}
-			ms2rt[i][j] = weightedCentroid;
-			filelist = filelist->next;	
-			j++;
 		}
+		ms1rt[j] = (valid == 0)? 0 : maxRT;
 	}
 	return;
 }
 
 
-void genMS1rtTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **ms1rt){
-
-	int i;
-	int j = 0;
-	SpectraFileNodePointer rootFilelist = filelist;
-	for(i = 0; i < peptideCount; ++i){
-		filelist = rootFilelist;
-		j = 0;
-		while(filelist != NULL){
-			SpectraFileNodePointer sfnp = peptides[i]->ms1SpectraFiles;
-			double maxIntensity = 0;
-			double maxRT = 0;
-			int valid = 0;
-			while(sfnp != NULL){	
-				if(!strcmp(sfnp->rawFile, filelist->rawFile) ){
-					ScanNodePointer snp = sfnp->scans;
-					while(snp != NULL){
-						int k;
-						double totalIntensity = 0;
-						for(k = 0; k < maxCharge - MIN_CHARGE + 1; ++k){
-							totalIntensity+=snp->intensity[k];
-						}
-						if(totalIntensity > maxIntensity){
-							maxIntensity = totalIntensity;
-							maxRT = snp->rt;
-						}
-						snp = snp->next;
-					}
-					snp = sfnp->scans;
-					while(snp != NULL){
-						if(fabs(snp->rt - maxRT) < 
-							peakWindow && snp->rt != maxRT){
-
-							valid = 1;
-						}
-						snp = snp->next;
-					}
-				}
-				sfnp = sfnp->next;
-			}
-			ms1rt[i][j] = (valid == 0)? 0 : maxRT;
-			filelist = filelist->next;	
-			j++;
-		}
-	}
+void medianRow(void *ptr, int index, int worker){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	pl->ms1median[index] = median(matrixRow(pl->ms1rt, index), pl->fileCount);
+	pl->ms2median[index] = median(matrixRow(pl->ms2rt, index), pl->fileCount);
 	return;
 }
 
 
-void medianRTtimes(double *ms1median, double *ms2median, double **ms1rt,	
-	double **ms2rt, int peptideCount, int fileCount, PeptidePointer *peptides){
-	
-	/*Calculate ms1 and ms2 retention times*/
+void printMedians(double *ms1median, double *ms2median, int peptideCount,
+	PeptidePointer *peptides){
+
 	int i;
-	for(i = 0; i < peptideCount; ++i){
-		ms1median[i] = median(ms1rt[i], fileCount);
-		ms2median[i] = median(ms2rt[i], fileCount);
-	}
 
 	/*print ms1 and ms2 median retention times*/
 	FILE *fp = fopen("median.txt", "w");
@@ -432,77 +725,41 @@ void medianRTtimes(double *ms1median, double *ms2median, double **ms1rt,
 	return;
 }
 
-void quant(double **ms2rt, double **quantification, PeptidePointer *peptides,
-	int peptideCount, SpectraFileNodePointer filelist){
-
-	SpectraFileNodePointer rootFilelist = filelist;
-	int i;
-	int j = 0;
-
-	for(i = 0; i < peptideCount; ++i){
-		filelist = rootFilelist;
-		j = 0;
-		while(filelist != NULL){
-			SpectraFileNodePointer sfnp = peptides[i]->ms1SpectraFiles;
-			double totalIntensity = 0;
-			while(sfnp != NULL){	
-				if(!strcmp(sfnp->rawFile, filelist->rawFile) ){
-					ScanNodePointer snp = sfnp->scans;
-					while(snp != NULL){
-						if(fabs(snp->rt - ms2rt[i][j]) < quantWindow){
-							int k;
-							int valid = 0;
-							double total = 0;
-							for(k = 0; k < maxCharge - MIN_CHARGE + 1; k++){
-								if(snp->corr[k] >= corrCutOff){
-									valid = 1;
-								}
-								total += snp->intensity[k];
-							}
-							totalIntensity+= valid == 1? total : 0;
-						}
-						snp = snp->next;
-					}
-					break;
-				}
-				sfnp = sfnp->next;
-			}
-			quantification[i][j] = totalIntensity;
-			filelist = filelist->next;	
-			j++;
+void quantRow(void *ptr, int index, int worker){
+	PipelinePointer pl = (PipelinePointer)ptr;
+	PeptidePointer pp = pl->peptides[index];
+	HitStorePointer ms1hits = pl->ms1hits;
+	double *ms2rt = matrixRow(pl->ms2rt, index);
+	double *quantification = matrixRow(pl->quantification, index);
+	int j, u, h;
+
+	if(pp->ms1Summaries != NULL){
+		for(j = 0; j < pl->fileCount; ++j){
+			quantification[j] = summaryIntensity(pp->ms1Summaries + j,
+				ms2rt[j]);
 		}
+		return;
 	}
-	return;
-}
-
-void countSpectra(PeptidePointer *peptides, int peptideCount,
-	SpectraFileNodePointer filelist, double **spectralCounts){
-
-	SpectraFileNodePointer rootFilelist = filelist;
-	int i;
-	int j = 0;
-
-	for(i = 0; i < peptideCount; ++i){
-		filelist = rootFilelist;
-		j = 0;
-		while(filelist != NULL){
-			SpectraFileNodePointer sfnp = peptides[i]->spectraFiles;
-			double count = 0;
-			while(sfnp != NULL){	
-				if(!strcmp(sfnp->rawFile, filelist->rawFile) ){
-					ScanNodePointer snp = sfnp->scans;
-					while(snp != NULL){
-						count+=1;
-						snp = snp->next;
+	int width = ms1hits->width;
+	int row = pp->row;
+	for(u = ms1hits->runStart[row]; u < ms1hits->runStart[row+1]; ++u){
+		j = ms1hits->runColumn[u];
+		double totalIntensity = 0;
+		for(h = ms1hits->hitStart[u]; h < ms1hits->hitStart[u+1]; ++h){
+			if(fabs(ms1hits->rt[h] - ms2rt[j]) < quantWindow){
+				int k;
+				int valid = 0;
+				double total = 0;
+				for(k = 0; k < width; k++){
+					if(ms1hits->corr[h*width + k] >= corrCutOff){
+						valid = 1;
 					}
-					break;
+					total += ms1hits->intensity[h*width + k];
 				}
-				sfnp = sfnp->next;
+				totalIntensity+= valid == 1? total : 0;
 			}
-			spectralCounts[i][j] = count;
-			filelist = filelist->next;	
-			j++;
 		}
+		quantification[j] = totalIntensity;
 	}
 	return;
 }
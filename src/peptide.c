@@ -26,21 +26,42 @@
 #include "global.h" //maxCharge, dataList
 #include "mzXML.h" //MZXMLPointer, readMZXML, delMZXML
 #include "isotope.h" //AMINO_ACIDS
+#include "xic.h" //XicStorePointer, newXicStore, peakIntensity, xicTrace
+#include "feature.h" //FeatureListPointer, findFeatures, featureRange
+#include "calibrate.h" //CalibrationPointer, newCalibration, calibrateMz
+#include "summary.h" //newMs1Summaries, anchorSummary, summariseHits
+#include "pool.h" //poolFor, poolScratch, poolSize
+#include "patterncache.h" //PatternCachePointer, cachedComposition
+#include "arena.h" //ArenaPointer, newArena, arenaAlloc, delArena
+#include "registry.h" //FileRegistryPointer, resolveFile, internFile
+#include "hits.h" //HitStorePointer, bufferHit, freeBuffer, bufferedHits
+#include "records.h" //RecordsPointer, nextRecord, splitRecord, fieldString
+#include "matrix.h" //MatrixPointer, matrixRow
 
 #include <stdio.h> //fprintf
-#include <string.h> //strncpy, strlen, memcpy, strcmp
+#include <string.h> //strncpy, strlen, memcpy, memmove, strcmp
 #include <stdlib.h> //malloc, free
 #include <ctype.h> //isupper
 #include <math.h> //fabs
-#include <pthread.h>
-#include <semaphore.h>
 #include <time.h>
 #include <dirent.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <stdint.h> //uint32_t
+#include <sys/stat.h> //stat
 
 #define STATQUEST_EXT ".txt"
-
-sem_t exit_sem_t;
+#define FEATURE_PAD 2 //store scans searched either side of a matched feature
+#define HIT_STRIPES 64 //locks guarding the charges of concurrent files
+#define MZXML_FOOTPRINT 4 //bytes of parse tree and spectra per mzXML byte
+#define PREFIX_CHUNK 64 //sorted peptides a worker extends prefixes over
+#define STORE_SIZE 1024 //initial slots of a peptide store, a power of two
+#define SORT_RUN 4096 //fewest peptides sorted by a single worker
+#define RECORD_CHUNK (1 << 22) //bytes of a results table a worker parses
+
+/*floats of trace scratch searchTraces needs for n scans*/
+#define TRACE_FLOATS(n) (isotopicStates*(maxCharge-MIN_CHARGE+1)*((n)+1) + \
+	(maxCharge-MIN_CHARGE+1)*2)
 
 /*
  * Structure used to package data need for a thread to search for a pep in an
@@ -48,54 +69,99 @@ sem_t exit_sem_t;
  */
 typedef struct spectraPackage {
 	struct mzxml *mzXML;
+	struct xicStore *xic; //NULL unless searching features
+	struct featureList *features; //NULL unless matching peptides to features
+	struct calibration *cal; //NULL unless the file was recalibrated
+	int fileIndex; //position of the mzXML in the filelist
+	double ms2RT; //ms2 centroid of pep in the mzXML, 0 if not identified
+	struct hitBuffer *hits; //ms1 hits of pep in the mzXML
 	struct peptide *pep;
 }SpectraPackage, *SpectraPackagePointer;
 
-//Sentinel for red-black tree
-Peptide TNILL = {NULL, NULL, NULL, NULL, BLACK, NULL, NULL, NULL};
+/*
+ * Structure shared by the files searched concurrently in a wave.
+ */
+typedef struct fileSearch {
+	struct peptide **peptides;
+	int peptideCount;
+	struct spectraFileNode **files; //filelist indexed by file index
+	int *wave; //file indices of the current wave
+	struct mzxml *first; //already read mzXML of file 0, or NULL
+	pthread_mutex_t *hitLocks; //HIT_STRIPES locks striped over peptides
+	struct hitStore *ms2hits; //identified ms2 scans of every peptide
+	struct hitStore **ms1hits; //ms1 hits of every file by file index
+}FileSearch, *FileSearchPointer;
 
-IsotopicPatternPointer *IPCollection; //IPC collection
+/*
+ * peptideRuns - Runs of width peptides sorted in from and merged into to.
+ */
+typedef struct peptideRuns {
+	PeptidePointer *from;
+	PeptidePointer *to;
+	int count;
+	int width;
+}PeptideRuns, *PeptideRunsPointer;
 
 /*
- * newScanNode - Allocate memory for a new newScanNode and intialize with   
- *     passed values. Return a pointer to new peak, NULL if error occured.   
+ * Search results files parsed on the pool, each into a store of its own.
  */
-ScanNodePointer newScanNode(int scanNum, float *intensity, float *corr);
+typedef struct fileParse {
+	char **paths;
+	struct peptideStore **parts; //store of every file by index
+	struct peptideStore *(*parser)(char *, struct peptideStore *);
+}FileParse, *FileParsePointer;
 
 /*
- * delScanNode - Free all memory allocated for the scanNode. Return pointer to
- *     next scanNode in linked list if exists, otherwise return NULL.
+ * Fields of a search results table record, resolved from the table header.
  */
-ScanNodePointer delScanNode(ScanNodePointer snp);
+typedef enum tableField {
+	RAW_FIELD,
+	SCAN_FIELD,
+	SEQUENCE_FIELD,
+	CHARGE_FIELD, //-1 when the table has no charges
+	TABLE_FIELDS
+} TableField;
 
 /*
- * addScanNode - Add a scan to a linked list of ScanNodes. ScanNodes will be 
- *     added in increasing order.                                            
+ * A tab delimited search results table parsed on the pool in chunks of whole
+ *     records, each into a store of its own.
  */
-ScanNodePointer addScanNode(ScanNodePointer root, int scanNum,
-	float *intensity, float *corr);
+typedef struct tableParse {
+	RecordsPointer rp;
+	size_t *bounds; //chunkCount+1 offsets chunks start and end at
+	int columns[TABLE_FIELDS];
+	const char *suffix; //appended to raw file names, NULL for none
+	struct peptideStore **parts; //store of every chunk by index
+}TableParse, *TableParsePointer;
 
 /*
- * delScanNodeList - Free memory allocated for an entire scanNodeList.
+ * Estimated memory needed to search a file, used to order and batch files.
  */
-ScanNodePointer delScanNodeList(ScanNodePointer snp);
+typedef struct fileCost {
+	int index;
+	double footprint;
+}FileCost, *FileCostPointer;
+
+
+IsotopicPatternPointer *IPCollection; //IPC collection
+PatternCachePointer patternCache; //patterns by composition, NULL if unused
+PrefixStackPointer *prefixStacks; //convolution prefixes held by each worker
 
 /*
- * newSpectraFileNode - Allocate memory for a new SpectraFileNode and intialize
- *     with passed values. Return a pointer to new SpectraFileNode, NULL if
- *     error occured.
+ * newSpectraFileNode - Allocate memory for a new SpectraFileNode and
+ *     intialize with passed values. Return a pointer to new SpectraFileNode,
+ *     NULL if error occured.
  */
-SpectraFileNodePointer newSpectraFileNode(char *rawFile, int scanNum,
-	float *intensity, float *corr);
+SpectraFileNodePointer newSpectraFileNode(int fileId, char *rawFile);
 
 /*
  * addSpectraFileNode - Add a SpectraFileNode to a linked list of
- *     SpectraFileNodes. Create a scanNode for the passed scanNum and add it to
- *     the SpectraFileNode's scan list. Return a pointer to the root of the
- *     list of SpectraFileNodes.
+ *     SpectraFileNodes ordered by decreasing name unless the file is already
+ *     listed. rawFile must be the registry's name for fileId. Return a
+ *     pointer to the root of the list of SpectraFileNodes.
  */
 SpectraFileNodePointer addSpectraFileNode(SpectraFileNodePointer root,
-	char *rawFile, int scanNum, float *intensity, float *corr);
+	int fileId, char *rawFile);
 
 /*
  * delSpectraFileNode - Free all memory allocated for the SpectraFileNode.  
@@ -105,86 +171,176 @@ SpectraFileNodePointer addSpectraFileNode(SpectraFileNodePointer root,
 SpectraFileNodePointer delSpectraFileNode(SpectraFileNodePointer sfnp);
 
 /*
- * rbLeftRotate - red black tree left rotate
+ * delPeptide - Free the heap memory held by the peptide. The peptide and its
+ *     sequence belong to the arenas of its store and are released with them.
+ *     Return NULL.
  */
-PeptidePointer rbLeftRotate(PeptidePointer root, PeptidePointer x);
+PeptidePointer delPeptide(PeptidePointer pp);
 
 /*
- * rbRightRotate - red black tree right rotate
+ * hashSequence - FNV-1a hash of a peptide sequence.
  */
-PeptidePointer rbRightRotate(PeptidePointer root, PeptidePointer y);
+uint32_t hashSequence(char *sequence);
 
 /*
- * rbInsertFixup - Ensures red black tree properties are maintained whilst
- *     inserting a node.
+ * findSlot - Return the slot of the store holding sequence, or the empty slot
+ *     where it would be inserted. Strings are only compared on equal hashes.
  */
-PeptidePointer rbInsertFixup(PeptidePointer root, PeptidePointer z);
+int findSlot(PeptideStorePointer store, char *sequence, uint32_t hash);
 
 /*
- * rbDeleteFixup - Ensures red black tree properties are maintained whilst 
- *     removing a node.
+ * growStore - Double the number of slots of the store and rehash its
+ *     peptides. Return 0 on success, -1 if out of memory.
  */
-PeptidePointer rbDeleteFixup(PeptidePointer root, PeptidePointer x);
+int growStore(PeptideStorePointer store);
 
 /*
- * rbDelete - Remove node z from the red black rooted at root.
+ * newPeptide - Allocate memory for a new peptide and intialize with passed  
+ *     values. Return a pointer to new peptide, NULL if error occured.       
  */
-PeptidePointer rbDelete(PeptidePointer root, PeptidePointer z);
+PeptidePointer newPeptide(ArenaPointer arena, char *sequence, int charge);
 
 /*
- * rbFree - Free memory allocated for the PeptidePointer.
+ * addPsm - Append an identification of the peptide to the store's PSMs.
+ *     Exits if out of memory.
  */
-PeptidePointer rbFree(PeptidePointer pp);
+void addPsm(PeptideStorePointer store, PeptidePointer pp, int fileId,
+	int scanNum);
 
 /*
- * rbTransplant - transplant function for red black trees of PeptidePointers.
+ * parseTask - Pool task parsing file index of a FileParse into a new store.
  */
-PeptidePointer rbTransplant(PeptidePointer root, PeptidePointer x,
-	PeptidePointer y);
+void parseTask(void *ptr, int index, int worker);
 
 /*
- * treeMin - Given the root of a peptide tree, return the minimal protein node.
+ * mergeStore - Move the peptides and identifications of part into store,
+ *     combining the charges of peptides found in both, then free part. The
+ *     arenas of part are handed to store.
  */
-PeptidePointer treeMin(PeptidePointer root);
+void mergeStore(PeptideStorePointer store, PeptideStorePointer part);
 
 /*
- * rbPrintInOrder - Given the root of a peptide tree, prints peptides in order.
- *     Used for debugging purposes.
+ * parseTable - Parse the tab delimited search results table filename into
+ *     store. If the first field of the table is first the table has a header
+ *     naming its fields, otherwise columns are used as they are. Raw file
+ *     names are followed by suffix unless it is NULL. Exits if the table
+ *     cannot be opened.
  */
-void rbPrintInOrder(PeptidePointer root);
+PeptideStorePointer parseTable(char *filename, const char *first,
+	const char *names[TABLE_FIELDS], int columns[TABLE_FIELDS],
+	const char *suffix, PeptideStorePointer store);
 
 /*
- * newPeptide - Allocate memory for a new peptide and intialize with passed  
- *     values. Return a pointer to new peptide, NULL if error occured.       
+ * tableTask - Pool task parsing chunk index of a TableParse into a new store.
+ */
+void tableTask(void *ptr, int index, int worker);
+
+/*
+ * parseStatQuest - Given a StatQuest results file populate the peptide store
+ *     and return it.
+ */
+PeptideStorePointer parseStatQuest(char *filename,
+	PeptideStorePointer store);
+
+/*
+ * comparePeptides - qsort comparator ordering PeptidePointers by sequence.
+ */
+int comparePeptides(const void *a, const void *b);
+
+/*
+ * sortRun - Pool task sorting run index of a PeptideRuns in place.
  */
-PeptidePointer newPeptide(char *rawFile, int scanNum, char *sequence);
+void sortRun(void *ptr, int index, int worker);
 
 /*
- * fillPeptides - Recursive function that populates an array of PeptidePointers
- *     inOrder given a tree of PeptidePointers.F
+ * mergeRuns - Pool task merging the index'th pair of sorted runs of a
+ *     PeptideRuns from its from array into its to array.
  */
-int fillPeptides(PeptidePointer root, int index, PeptidePointer *peptides);
+void mergeRuns(void *ptr, int index, int worker);
 
 /*
- * searchSpectra - given a scan and peptide determine whether the peptide's
+ * sortPeptides - Sort an array of PeptidePointers by sequence, sorting runs
+ *     on the pool and merging them pairwise.
+ */
+void sortPeptides(PeptidePointer *peptides, int count);
+
+/*
+ * searchSpectra - Search the package's file for its peptide by features or
+ *     scan by scan and fold the hits into the peptide's summary of
+ *     the file when streaming. Pool task over an array of
+ *     SpectraPackagePointers.
+ */
+void searchSpectra(void *ptr, int index, int worker);
+
+/*
+ * searchScans - given a scan and peptide determine whether the peptide's
  *     theoretical isotopic profile is present in the ms1 spectra and if match
  *     meets required conditions then store the hit in appropriate field in 
  *     peptide structure.
  */
-void searchSpectra( void *ptr);
+void searchScans(SpectraPackagePointer package);
+
+/*
+ * searchTraces - given an XIC store and peptide extract the chromatogram of
+ *     every isotope of the peptide's theoretical isotopic profile at every
+ *     searched charge over store scans [first, last), then apply the same per
+ *     scan checks as searchScans to the extracted chromatograms and store
+ *     the hits in the peptide. traces holds TRACE_FLOATS(last - first)
+ *     floats.
+ */
+void searchTraces(SpectraPackagePointer package, int first, int last,
+	float *traces);
+
+/*
+ * searchFeatures - given the features of a file match the lightest isotope of
+ *     the peptide's theoretical isotopic profile to features of a searched
+ *     charge by mass, and by apex retention time if the peptide was
+ *     identified in the file, and search the traces of only the scans those
+ *     features span.
+ */
+void searchFeatures(SpectraPackagePointer package);
+
+/*
+ * recordHit - Buffer a valid hit of the package's peptide in the passed scan.
+ */
+void recordHit(SpectraPackagePointer package, int scanNum, float *intensity,
+	float *corr);
+
+/*
+ * searchFile - Read a single mzXML and search it for the isotopic pattern of
+ *     every peptide. Pool task over the file indices of a FileSearch wave.
+ */
+void searchFile(void *ptr, int index, int worker);
+
+/*
+ * fileFootprint - Estimate the bytes needed to read and search the mzXML
+ *     from its size on disk. Return 0 if the file can not be found.
+ */
+double fileFootprint(char *filename);
+
+/*
+ * compareFileCost - Order files by descending footprint then by index.
+ */
+int compareFileCost(const void *a, const void *b);
+
+/*
+ * compareRange - Order (first, last) scan ranges by first scan.
+ */
+int compareRange(const void *a, const void *b);
 
 /*
  * checkChargeStates - search for mzs of a theoretical isotopic profile within 
  *     the ms1 spectra recording intensities for hits. Return 1 if at least one
  *     charge state showed all required peaks.
  */
-int checkChargeStates(ScanPointer sp, float *foundPattern, float *isoMass, char *seq, char*filename);
+int checkChargeStates(ScanPointer sp, float *foundPattern, float *isoMass,
+	double tolerance);
 
 /*
- * binSearch - a traditional binary search except rather than direct equality
- *     we require mzs be within ppmCutOff ppm of each other.
+ * patternFound - Return 1 if at least one charge state of the found pattern
+ *     showed all required peaks.
  */
-float *binSearch(float mz, float *head, float *tail);
+int patternFound(float *foundPattern);
 
 /*
  * checkHit - check if any of the charge states passed the correlation and
@@ -193,10 +349,25 @@ float *binSearch(float mz, float *head, float *tail);
 int checkHit(float *intensity, float *foundPattern, float *corr);
 
 /*
- * makePeptideThreadFunc - Helper function for generating an peptide isotopic 
- *     pattern in a threaded environment.
+ * addCharge - Record that the peptide was identified at the passed charge.
+ *     Charges that are unknown (0) or too large to track are ignored.
+ */
+void addCharge(PeptidePointer pp, int charge);
+
+/*
+ * chargeAllowed - Return 1 if the ms1 search for the peptide should include
+ *     the passed charge. When charge restriction is enabled only charges
+ *     within chargeWindow of an observed charge are searched. Peptides with
+ *     no observed charges are searched at every charge.
+ */
+int chargeAllowed(PeptidePointer pp, int charge);
+
+/*
+ * makePeptideTask - Helper function for generating an peptide isotopic 
+ *     pattern in a threaded environment. Pool task over an array of
+ *     PeptidePointers.
  */
-void *makePeptideThreadFunc( void *ptr );
+void makePeptideTask(void *ptr, int index, int worker);
 
 /*
  * sendModsLeft - Rearranges the mods in an amino acid sequence so that mods 
@@ -205,141 +376,40 @@ void *makePeptideThreadFunc( void *ptr );
  */
 void sendModsLeft(char *sequence);
 
-/*
- * inList - check whether the passed filename is within the user defined data
- *     list. If so return the path in the user defined list otherwise return
- *     NULL.
- */
-char *inList(char *filename);
-
 ///////////////////////////////////////////////////////////////////////////////
 //                       END OF FUNCTION DECLARATIONS                        //
 ///////////////////////////////////////////////////////////////////////////////
 
-ScanNodePointer newScanNode(int scanNum, float *intensity, float *corr){
-	ScanNodePointer snp = (ScanNodePointer)malloc(sizeof(ScanNode));
-	if(snp == NULL){
-		fprintf(stderr, "\nERROR: Out of memory - cannot create scanNode!\n");
-	}else{
-		snp->scanNum = scanNum;
-		snp->rt = 0;
-		snp->next = NULL;
-		snp->intensity = NULL;
-		snp->corr = NULL;
-	}
-	if(intensity != NULL && corr != NULL){
-		int size = maxCharge - MIN_CHARGE + 1;
-		snp->intensity = (float*)malloc(size * sizeof(float));
-		snp->corr = (float*)malloc(size * sizeof(float));
-		if(snp->intensity == NULL || snp->corr == NULL){
-			fprintf(stderr,
-			 "\nERROR: Out of memory - cannot create scanNode!\n");
-		}else{
-			memcpy(snp->intensity, intensity, size * sizeof(float));
-			memcpy(snp->corr, corr, size * sizeof(float));
-		}
-	}
-	return snp;
-}
-
-
-ScanNodePointer delScanNode(ScanNodePointer snp){
-	if(snp == NULL){
-		return NULL;
-	}
-	if(snp->intensity != NULL){
-		free(snp->intensity);
-	}
-	if(snp->corr != NULL){
-		free(snp->corr);
-	}	
-	ScanNodePointer next = snp->next;
-	snp->next = NULL;
-	free(snp);
-	snp = NULL;
-	return next;
-}
-
-
-ScanNodePointer addScanNode(ScanNodePointer root, int scanNum,
-	float *intensity, float *corr){
-	
-	ScanNodePointer cur;
-	ScanNodePointer prev;
-	for(cur = root, prev = NULL;
-		cur != NULL && cur->scanNum < scanNum;
-		prev = cur, cur = cur->next)
-		;
-	if(cur != NULL && cur->scanNum == scanNum){
-		return root; //scan linked list does not change
-	}
-	ScanNodePointer new = newScanNode(scanNum, intensity, corr);
-	new->next = cur;
-	if(!prev){
-		return new;
-	}else{
-		prev->next = new;
-		return root;
-	}
-
-}
-
-
-ScanNodePointer delScanNodeList(ScanNodePointer snp){
-	if(snp == NULL){
-		return NULL;
-	}
-	while(snp != NULL){
-		snp = delScanNode(snp);
-	}	
-	return snp;
-}
-
-
-SpectraFileNodePointer newSpectraFileNode(char *rawFile, int scanNum,
-	float *intensity, float *corr){
-	SpectraFileNodePointer sfnp = 
-		(SpectraFileNodePointer)malloc(sizeof(SpectraFileNode));
+SpectraFileNodePointer newSpectraFileNode(int fileId, char *rawFile){
+	SpectraFileNodePointer sfnp = (SpectraFileNodePointer)malloc(
+		sizeof(SpectraFileNode));
 	if(sfnp == NULL){fprintf(stderr,
 		"\nERROR: Out of memory - cannot create spectraFileNode!\n");
 	}else{
-		sfnp->rawFile = (char *)malloc( (strlen(rawFile) + 1)*sizeof(char));
-		if(sfnp->rawFile == NULL){
-			fprintf(stderr,
-				"\nERROR: Out of memory - cannot create spectraFileNode!\n");
-		}else{
-			strncpy(sfnp->rawFile, rawFile, strlen(rawFile)+1 ); 
-			//sfnp->rawFile[strlen(rawFile)] = '\0';
-			sfnp->next = NULL;
-			sfnp->scans = newScanNode(scanNum, intensity, corr);
-		}
+		sfnp->rawFile = rawFile;
+		sfnp->fileId = fileId;
+		sfnp->next = NULL;
 	}
 	return sfnp;
 }
 
 
 SpectraFileNodePointer addSpectraFileNode(SpectraFileNodePointer root,
-	char *rawFile, int scanNum, float *intensity, float *corr){
-
-	// added 2014-01-20 check if data list was passed, if so check if rawfile
-	// is in that list and update it's real path if it is
-	if(dataList){
-		rawFile = inList(rawFile);
-		if(!rawFile) return root;
-	}
+	int fileId, char *rawFile){
 
 	SpectraFileNodePointer cur;
 	SpectraFileNodePointer prev;
+	for(cur = root; cur != NULL && cur->fileId != fileId; cur = cur->next)
+		;
+	if(cur != NULL){
+		return root; //sfn linked list does not change
+	}
+
 	for(cur = root, prev = NULL;
 		cur != NULL && strcmp(cur->rawFile, rawFile) > 0;
 		prev = cur, cur = cur->next)
 		;
-	if(cur != NULL && !strcmp(cur->rawFile, rawFile)){
-		cur->scans = addScanNode(cur->scans, scanNum, intensity, corr);
-		return root; //sfn linked list does not change
-	}
-	SpectraFileNodePointer new = newSpectraFileNode(rawFile, scanNum,
-			intensity, corr);
+	SpectraFileNodePointer new = newSpectraFileNode(fileId, rawFile);
 	new->next = cur;
 	if(!prev){
 		return new;
@@ -356,443 +426,503 @@ SpectraFileNodePointer delSpectraFileNode(SpectraFileNodePointer sfnp){
 	}
 	SpectraFileNodePointer next =  sfnp->next;
 	sfnp->next = NULL;
-	if(sfnp->rawFile != NULL){
-		free(sfnp->rawFile);
-	}
-	if(sfnp->scans != NULL){
-		sfnp->scans = delScanNodeList(sfnp->scans);
-	}
 	free(sfnp);
 	sfnp = NULL;
 	return next;
 }
 
 
-PeptidePointer rbLeftRotate(PeptidePointer root, PeptidePointer x){
-	PeptidePointer y = x->right;
-	x->right = y->left;
-	if(y->left != &TNILL){
-		y->left->parent = x;
+PeptidePointer delPeptide(PeptidePointer pp){
+	if(pp == NULL){
+		return NULL;
 	}
-	y->parent = x->parent;
-	if(x->parent == &TNILL){
-		root = y;
-	}else if(x == x->parent->left){
-		x->parent->left = y;
-	}else{
-		x->parent->right = y;
+	if(pp->ip != NULL){
+		pp->ip = delIsotopicPattern(pp->ip);
 	}
-	y->left = x;
-	x->parent = y;
-	
-	return root;
+	if(pp->ms1Summaries != NULL){
+		pp->ms1Summaries = delMs1Summaries(pp->ms1Summaries);
+	}
+	pp = NULL;
+	return pp;
 }
 
 
-PeptidePointer rbRightRotate(PeptidePointer root, PeptidePointer y){
-	PeptidePointer x = y->left;
-	y->left = x->right;
-	if(x->right != &TNILL){
-		x->right->parent = y;
+uint32_t hashSequence(char *sequence){
+	uint32_t hash = 2166136261u;
+	while(*sequence != '\0'){
+		hash ^= (unsigned char)*sequence++;
+		hash *= 16777619u;
 	}
-	x->parent = y->parent;
-	if(y->parent == &TNILL){
-		root = x;
-	}else if(y == y->parent->right){
-		y->parent->right = x;
-	}else{
-		y->parent->left = x;
+	return hash;
+}
+
+
+int findSlot(PeptideStorePointer store, char *sequence, uint32_t hash){
+	int mask = store->size - 1;
+	int i = hash & mask;
+	while(store->slots[i] != NULL && (store->hashes[i] != hash ||
+		strcmp(sequence, store->slots[i]->sequence))){
+		i = (i + 1) & mask;
 	}
-	x->right = y;
-	y->parent = x;
-	
-	return root;
+	return i;
 }
 
 
-PeptidePointer rbInsertFixup(PeptidePointer root, PeptidePointer z){
-	while (z->parent->colour == RED){
-		if(z->parent == z->parent->parent->left){ //z->p is a left child
-			PeptidePointer y = z->parent->parent->right; //sibling of z->p
-			if(y->colour == RED){
-				z->parent->colour = BLACK;
-				y->colour = BLACK;
-				z->parent->parent->colour = RED;
-				z = z->parent->parent;
-			}else{ //y is black
-				if(z == z->parent->right){ //z is right
-					z = z->parent;
-					root = rbLeftRotate(root, z);
-				}
-				z->parent->colour = BLACK;
-				z->parent->parent->colour = RED;
-				root = rbRightRotate(root, z->parent->parent);
-			}
-		}else{ //z-> is a right child
-			PeptidePointer y = z->parent->parent->left;
-			if(y->colour == RED){
-				z->parent->colour = BLACK;
-				y->colour = BLACK;
-				z->parent->parent->colour = RED;
-				z = z->parent->parent;
-			}else{ //y is black
-				if(z == z->parent->left){
-					z = z->parent;
-					root = rbRightRotate(root, z);
-				}
-				z->parent->colour = BLACK;
-				z->parent->parent->colour = RED;
-				root = rbLeftRotate(root, z->parent->parent);
-			}	
+int growStore(PeptideStorePointer store){
+	int i;
+	PeptidePointer *slots = store->slots;
+	uint32_t *hashes = store->hashes;
+	int size = store->size;
+
+	store->slots = (PeptidePointer *)calloc(2 * size, sizeof(PeptidePointer));
+	store->hashes = (uint32_t *)malloc(2 * size * sizeof(uint32_t));
+	if(store->slots == NULL || store->hashes == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot grow peptide store!\n");
+		free(store->slots);
+		free(store->hashes);
+		store->slots = slots;
+		store->hashes = hashes;
+		return -1;
+	}
+	store->size = 2 * size;
+	for(i = 0; i < size; ++i){
+		if(slots[i] != NULL){
+			int j = findSlot(store, slots[i]->sequence, hashes[i]);
+			store->slots[j] = slots[i];
+			store->hashes[j] = hashes[i];
 		}
 	}
-	root->colour = BLACK;
-	return root;
+	free(slots);
+	free(hashes);
+	return 0;
 }
 
 
-PeptidePointer rbDeleteFixup(PeptidePointer root, PeptidePointer x){
-	while(x != root && x->colour == BLACK){
-		if(x == x->parent->left){
-			PeptidePointer w = x->parent->right;
-			if(w->colour == RED){
-				w->colour = BLACK;
-				x->parent->colour = RED;	
-				root = rbLeftRotate(root, x->parent);
-				w = x->parent->right;
-			}
-			if(w->left->colour == BLACK && w->right->colour == BLACK){
-				w->colour = RED;
-				x = x->parent;
-			}else{
-				if(w->right->colour == BLACK){
-					w->left->colour = BLACK;
-					w->colour = RED;
-					root = rbRightRotate(root, w);
-					w = x->parent->right;
-				}
-				w->colour = x->parent->colour;
-				x->parent->colour = BLACK;
-				w->right->colour = BLACK;
-				root = rbLeftRotate(root, x->parent);
-				x = root;
-			}
+PeptidePointer newPeptide(ArenaPointer arena, char *sequence, int charge){
+	PeptidePointer pp = (PeptidePointer)arenaAlloc(arena, sizeof(Peptide));
+	if(!pp){
+		fprintf(stderr,
+			 "\nERROR: Out of memory - cannot create Peptide!\n");
+	}else{
+		/*parse the sequence once, every stage uses the encoding*/
+		int length = strlen(sequence);
+		pp->sequence = arenaString(arena, sequence);
+		pp->stripped = (char *)arenaAlloc(arena, length + 1);
+		pp->codes = (unsigned char *)arenaAlloc(arena, length + 1);
+		if(!pp->sequence || !pp->stripped || !pp->codes){
+			fprintf(stderr,
+			 "\nERROR: Out of memory - cannot create Peptide!\n");
+			pp = NULL;
 		}else{
-			PeptidePointer w = x->parent->left;
-			if(w->colour == RED){
-				w->colour = BLACK;
-				x->parent->colour = RED;	
-				root = rbRightRotate(root, x->parent);
-				w = x->parent->left;
-			}
-			if(w->right->colour == BLACK && w->left->colour == BLACK){
-				w->colour = RED;
-				x = x->parent;
-			}else{
-				if(w->left->colour == BLACK){
-					w->right->colour = BLACK;
-					w->colour = RED;
-					root = rbLeftRotate(root, w);
-					w = x->parent->left;
+			int i, j;
+			for(i = 0, j = 0; i < length; ++i){
+				if(strchr(AMINO_ACIDS, sequence[i])){
+					pp->stripped[j++] = sequence[i];
 				}
-				w->colour = x->parent->colour;
-				x->parent->colour = BLACK;
-				w->left->colour = BLACK;
-				root = rbRightRotate(root, x->parent);
-				x = root;
 			}
+			pp->stripped[j] = '\0';
+			pp->codeCount = encodePeptide(sequence, pp->codes);
+			pp->heavy = sequence[0] == '*';
+			pp->row = -1;
+			pp->ms1Summaries = NULL;
+			pp->charges = 0;
+			addCharge(pp, charge);
+			pp->ip = NULL;
 		}
 	}
-	x->colour = BLACK;
-	return root;
+	return pp;
 }
 
 
-PeptidePointer rbDelete(PeptidePointer root, PeptidePointer z){
-	PeptidePointer x;
-	PeptidePointer y = z;
-	NodeColour origYcolour = y->colour;
-	if(z->left == &TNILL){
-		x = z->right;
-		root = rbTransplant(root, z, z->right);	
-	}else if(z->right == &TNILL){
-		x = z->left;
-		root = rbTransplant(root, z, z->left);	
-	}else{
-		y = treeMin(z->right);
-		origYcolour = y->colour;
-		x = y->right;
-		if(y->parent == z){
-			x->parent = y;
-		}else{
-			root = rbTransplant(root, y, y->right);	
-			y->right = z->right;	
-			y->right->parent = y;
-		}
-		root = rbTransplant(root, z, y);
-		y->left = z->left;
-		y->left->parent = y;
-		y->colour = z->colour;
+PeptideStorePointer parseFiles(char **paths, int count,
+	PeptideStorePointer (*parser)(char *, PeptideStorePointer),
+	PeptideStorePointer store){
+	int i;
+	FileParse fp = {paths, NULL, parser};
+	fp.parts = (PeptideStorePointer *)calloc(count + 1,
+		sizeof(PeptideStorePointer));
+	if(fp.parts == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot parse results!\n");
+		exit(1);
 	}
-	if(origYcolour == BLACK){
-		root = rbDeleteFixup(root, x);
+	poolFor(count, 1, parseTask, &fp);
+
+	/*merge in file order so the store does not depend on scheduling*/
+	for(i = 0; i < count; ++i){
+		mergeStore(store, fp.parts[i]);
 	}
-	z = rbFree(z);
-	return root;
+	free(fp.parts);
+	return store;
 }
 
 
-PeptidePointer rbFree(PeptidePointer pp){
-	if(pp == NULL){
-		return NULL;
+void parseTask(void *ptr, int index, int worker){
+	FileParsePointer fp = (FileParsePointer)ptr;
+	PeptideStorePointer part = newPeptideStore();
+	if(part == NULL){
+		exit(1);
+	}
+	fp->parts[index] = fp->parser(fp->paths[index], part);
+}
+
+
+void mergeStore(PeptideStorePointer store, PeptideStorePointer part){
+	int i;
+
+	/*peptides new to store are moved, their memory comes with the arenas*/
+	for(i = 0; i < part->size; ++i){
+		PeptidePointer x = part->slots[i];
+		if(x == NULL){
+			continue;
+		}
+		int j = findSlot(store, x->sequence, part->hashes[i]);
+		if(store->slots[j] != NULL){
+			store->slots[j]->charges |= x->charges;
+			continue;
+		}
+		if(2 * (store->count + 1) > store->size){
+			if(growStore(store)){
+				exit(1);
+			}
+			j = findSlot(store, x->sequence, part->hashes[i]);
+		}
+		store->slots[j] = x;
+		store->hashes[j] = part->hashes[i];
+		store->count++;
+		part->slots[i] = NULL;
 	}
-	pp->parent = NULL;
-	pp->left = NULL;
-	pp->right = NULL;
 
-	if(pp->sequence != NULL){
-		free(pp->sequence);
+	/*identifications refer to the peptide and file ids of store*/
+	int *ids = (int *)malloc( (part->files->count + 1) * sizeof(int));
+	if(ids == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot merge results!\n");
+		exit(1);
 	}
-	if(pp->ip != NULL){
-		pp->ip = delIsotopicPattern(pp->ip);
+	for(i = 0; i < part->files->count; ++i){
+		ids[i] = internFile(store->files, fileName(part->files, i));
 	}
-	if(pp->spectraFiles != NULL){
-		pp->spectraFiles = delSpectraFileList(pp->spectraFiles);
+	for(i = 0; i < part->psmCount; ++i){
+		PsmPointer psm = part->psms + i;
+		char *sequence = psm->pep->sequence;
+		addPsm(store, store->slots[findSlot(store, sequence,
+			hashSequence(sequence))], ids[psm->fileId], psm->scanNum);
 	}
-	if(pp->ms1SpectraFiles != NULL){
-		pp->ms1SpectraFiles = delSpectraFileList(pp->ms1SpectraFiles);
+	free(ids);
+
+	ArenaPointer *arenas = (ArenaPointer *)realloc(store->arenas,
+		(store->arenaCount + part->arenaCount) * sizeof(ArenaPointer));
+	if(arenas == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot merge results!\n");
+		exit(1);
 	}
-	free(pp);
-	pp = NULL;
-	return pp;
+	store->arenas = arenas;
+	memcpy(store->arenas + store->arenaCount, part->arenas,
+		part->arenaCount * sizeof(ArenaPointer));
+	store->arenaCount += part->arenaCount;
+	part->arenaCount = 0;
+	part = delPeptideStore(part);
 }
 
 
-PeptidePointer rbTransplant(PeptidePointer root, PeptidePointer x,
-	PeptidePointer y){
-	
-	if(x->parent == &TNILL){
-		root = y;
-	}else if(x == x->parent->left){
-		x->parent->left = y;
-	}else{
-		x->parent->right = y;
-	}
-	y->parent = x->parent;
+int comparePeptides(const void *a, const void *b){
+	return strcmp((*(PeptidePointer *)a)->sequence,
+		(*(PeptidePointer *)b)->sequence);
+}
 
-	return root;
+
+void sortRun(void *ptr, int index, int worker){
+	PeptideRunsPointer pr = (PeptideRunsPointer)ptr;
+	int start = index * pr->width;
+	int end = start + pr->width < pr->count ? start + pr->width : pr->count;
+	qsort(pr->from + start, end - start, sizeof(PeptidePointer),
+		comparePeptides);
 }
 
 
-PeptidePointer treeMin(PeptidePointer root){
-	while(root->left != &TNILL){
-		root = root->left;
+void mergeRuns(void *ptr, int index, int worker){
+	PeptideRunsPointer pr = (PeptideRunsPointer)ptr;
+	int start = 2 * index * pr->width;
+	int mid = start + pr->width < pr->count ? start + pr->width : pr->count;
+	int end = mid + pr->width < pr->count ? mid + pr->width : pr->count;
+	int i = start;
+	int j = mid;
+	int k = start;
+	while(i < mid && j < end){
+		if(comparePeptides(pr->from + j, pr->from + i) < 0){
+			pr->to[k++] = pr->from[j++];
+		}else{
+			pr->to[k++] = pr->from[i++];
+		}
+	}
+	while(i < mid){
+		pr->to[k++] = pr->from[i++];
+	}
+	while(j < end){
+		pr->to[k++] = pr->from[j++];
 	}
-	return root;
 }
 
 
-void rbPrintInOrder(PeptidePointer root){
-	if(root != &TNILL){
-		rbPrintInOrder(root->right);
-		printf("[%s]%s\n", root->colour == RED? "RED" : "BLACK",
-			root->sequence);
-		rbPrintInOrder(root->left);
+void sortPeptides(PeptidePointer *peptides, int count){
+	PeptideRuns pr = {peptides, NULL, count, 0};
+	pr.width = (count + poolSize() - 1) / poolSize();
+	if(pr.width < SORT_RUN){
+		pr.width = SORT_RUN;
+	}
+	if(pr.width < count){
+		pr.to = (PeptidePointer *)malloc(count * sizeof(PeptidePointer));
+	}
+	if(pr.to == NULL){
+		qsort(peptides, count, sizeof(PeptidePointer), comparePeptides);
+		return;
+	}
+
+	/*sort a run per worker then merge neighbouring runs pairwise*/
+	poolFor((count + pr.width - 1) / pr.width, 1, sortRun, &pr);
+	while(pr.width < count){
+		poolFor((count + 2 * pr.width - 1) / (2 * pr.width), 1, mergeRuns,
+			&pr);
+		PeptidePointer *swap = pr.from;
+		pr.from = pr.to;
+		pr.to = swap;
+		pr.width *= 2;
+	}
+	if(pr.from != peptides){
+		memcpy(peptides, pr.from, count * sizeof(PeptidePointer));
+		pr.to = pr.from;
 	}
+	free(pr.to);
 }
 
 
-PeptidePointer newPeptide(char *rawFile, int scanNum, char *sequence){
-	PeptidePointer pp = (PeptidePointer)malloc(sizeof(Peptide));
-	if(!pp){
-		fprintf(stderr,
-			 "\nERROR: Out of memory - cannot create Peptide!\n");
+void searchSpectra(void *ptr, int index, int worker){
+	SpectraPackagePointer package = ((SpectraPackagePointer *)ptr)[index];
+	PeptidePointer pp = package->pep;
+	if(package->features != NULL){
+		searchFeatures(package);
 	}else{
-		pp->sequence = malloc(strlen(sequence)+1);
-		if(!pp->sequence){
-			fprintf(stderr,
-			 "\nERROR: Out of memory - cannot create Peptide!\n");
-			free(pp);
-		}else{
-			strncpy(pp->sequence, sequence, strlen(sequence)+1);
-			pp->spectraFiles = addSpectraFileNode(NULL, rawFile, scanNum, NULL, NULL);
-			pp->ms1SpectraFiles = NULL;
-			pp->ip = NULL;
-			pp->colour = RED;
-			pp->parent = &TNILL;
-			pp->left = &TNILL;
-			pp->right = &TNILL;
-		}
+		searchScans(package);
 	}
-	return pp;
-}
 
-
-int fillPeptides(PeptidePointer root, int index, PeptidePointer *peptides){
-	if(root != &TNILL){
-		index = fillPeptides(root->left, index, peptides);
-		peptides[index++] = root;
-		index = fillPeptides(root->right, index, peptides);
+	/*every hit of the peptide in the file is known once its search ends, so
+	the summary is folded from them and the buffer freed right away*/
+	if(pp->ms1Summaries != NULL){
+		summariseHits(pp->ms1Summaries + package->fileIndex, package->hits,
+			maxCharge - MIN_CHARGE + 1, package->mzXML);
+		freeBuffer(package->hits);
 	}
-	return index;
+	return;
 }
 
 
-void searchSpectra(void *ptr ){
+void searchScans(SpectraPackagePointer package){
 	int i, j, k;
+	MZXMLPointer mzXML = package->mzXML;
+	PeptidePointer pp = package->pep;
+	CalibrationPointer cal = package->cal;
 
-	MZXMLPointer mzXML = ((SpectraPackagePointer)ptr)->mzXML;
-	PeptidePointer pp = ((SpectraPackagePointer)ptr)->pep;
-
-	float *isoMass = (float*)malloc(
-				isotopicStates*(maxCharge-MIN_CHARGE+1)*2*sizeof(float));
-	float *foundPattern = isoMass + isotopicStates*(maxCharge-MIN_CHARGE+1);
+	/*scratch is reused by every peptide the worker searches*/
+	int states = isotopicStates*(maxCharge-MIN_CHARGE+1);
+	float *isoMass = (float*)poolScratch(
+		(2*states + (maxCharge-MIN_CHARGE+1)*2)*sizeof(float));
+	if(isoMass == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot search spectra!\n");
+		return;
+	}
+	float *foundPattern = isoMass + states;
 
-	float *corr = (float*)malloc( (maxCharge-MIN_CHARGE+1)*2*sizeof(float));
+	float *corr = foundPattern + states;
 	float *intensity = corr + maxCharge-MIN_CHARGE+1;
 
-	for(k = 0; k < mzXML->scanCount; ++k){
+	/*skip the peptide entirely if none of its charges are searchable*/
+	int searchable = 0;
+	for(i = MIN_CHARGE; i <= maxCharge; ++i){
+		searchable += chargeAllowed(pp, i);
+	}
+
+	for(k = 0; searchable && k < mzXML->scanCount; ++k){
 		if(mzXML->scans[k]->msLevel == 1){
 			if(mzXML->scans[k]->peaksCount >= MIN_PEAK_COUNT){
 			ScanPointer sp = mzXML->scans[k];	
 			for(i = MIN_CHARGE; i <= maxCharge; ++i){
+				int allowed = chargeAllowed(pp, i);
 				for(j = 0; j < isotopicStates; ++j){
-					isoMass[(maxCharge - i)*isotopicStates+j] = 
-						(pp->ip->mass[j]+(PROTON*i))/i;
+					/*a mass of 0 marks the charge as excluded*/
+					isoMass[(maxCharge - i)*isotopicStates+j] = allowed?
+						calibrateMz(cal, (pp->ip->mass[j]+(PROTON*i))/i,
+						sp->retentionTime) : 0;
 					foundPattern[(maxCharge - i)*isotopicStates+j] = 0;
 				}
 			}
 
 			/*search for hits*/
-			int valid = checkChargeStates(sp, foundPattern, isoMass, pp->sequence, mzXML->filename);
+			int valid = checkChargeStates(sp, foundPattern, isoMass,
+				calibratedTolerance(cal));
 			/*check hit correlation and validity. record valid hits*/
 			if(valid &&
 				pearson(pp->ip->intensity, foundPattern, corr) >= corrCutOff &&
 				checkHit(intensity, foundPattern, corr) ){
 
-				pp->ms1SpectraFiles = addSpectraFileNode(pp->ms1SpectraFiles,
-				mzXML->filename, sp->scanNum, intensity, corr);
+				recordHit(package, sp->scanNum, intensity, corr);
 			}
 		}
 		}
 	}
-	free(isoMass);
-	free(corr);	
-	sem_post (&exit_sem_t);
 }
 
-/*
- * sumPeak - Given a pointer to the intensity value of either extremes of a
- *     peak, sum all peaks belonging to the peak by progressing through the
- *     intensity left in the direction specified. A -1 direction means
- *     left and a +1 direction means right. The peak boundary is set at the
- *     nearest zero intensity or next nondecreasing intensity value.
- */
-float sumPeak(float *point, ScanPointer sp, int direction, char *seq, char*filename, int scan){
-	if(direction != -1 && direction != 1){
-		fprintf(stderr, "The direction passed to sumPeak was not +/-1\n");
-		exit(EXIT_FAILURE);
-	}
-	int goinDown = 0; //are we moving up the side of the peak
-	float total_intensity = 0;
-	while(point != NULL){
-		total_intensity += *point;
-		float *next = point + direction;
-		//printf("%s\t%s\t%d\t%f\t%f\t%d\n", seq, filename, scan, *point, *(sp->mzList+(point - sp->intList)), goinDown);
-
-		if(*next < 0.001)
-			break;
-		if( !goinDown && (*next - *point ) < 0)
-			goinDown = 1;
-		else if( goinDown && (*next - *point ) > 0 )
-			break;
-		point = next;
-	}
-	return total_intensity;
+void searchTraces(SpectraPackagePointer package, int first, int last,
+	float *traces){
+	int i, j, k;
+	XicStorePointer xs = package->xic;
+	PeptidePointer pp = package->pep;
+	int n = last - first;
+	int states = isotopicStates*(maxCharge-MIN_CHARGE+1);
+	float *foundPattern = traces + states*n;
+	float *corr = foundPattern + states;
+	float *intensity = corr + maxCharge-MIN_CHARGE+1;
+
+	/*extract one chromatogram per isotope and charge*/
+	for(i = MIN_CHARGE; i <= maxCharge; ++i){
+		int allowed = chargeAllowed(pp, i);
+		for(j = 0; j < isotopicStates; ++j){
+			float *trace = traces + ((maxCharge - i)*isotopicStates+j)*n;
+			if(allowed){
+				xicTrace(xs, (pp->ip->mass[j]+(PROTON*i))/i, first, last,
+					package->cal, trace);
+			}else{
+				memset(trace, 0, n*sizeof(float));
+			}
+		}
+	}
+
+	/*check hit correlation and validity scan by scan. record valid hits*/
+	for(k = 0; k < n; ++k){
+		for(i = 0; i < states; ++i){
+			foundPattern[i] = traces[i*n + k];
+		}
+		if(patternFound(foundPattern) &&
+			pearson(pp->ip->intensity, foundPattern, corr) >= corrCutOff &&
+			checkHit(intensity, foundPattern, corr) ){
+
+			recordHit(package, xs->scanNum[first + k], intensity, corr);
+		}
+	}
 }
 
 
-int checkChargeStates(ScanPointer sp, float *foundPattern, float *isoMass, char *seq, char*filename){
+void searchFeatures(SpectraPackagePointer package){
+	int i, j;
+	XicStorePointer xs = package->xic;
+	FeatureListPointer fl = package->features;
+	PeptidePointer pp = package->pep;
+
+	/*features are indexed by the mass of their lightest isotope*/
+	double mass = pp->ip->mass[0];
+	for(j = 1; j < isotopicStates; ++j){
+		if(pp->ip->mass[j] < mass){
+			mass = pp->ip->mass[j];
+		}
+	}
 
-	float *head = sp->mzList;
-	float *tail = head + sp->peaksCount - 1;
-	int i , j;
-	for(i = 0; i < isotopicStates*maxCharge; ++i){	
-		float *index = binSearch(isoMass[i], head, tail);
-		if(index != NULL){
-			// find value closest to isoMass[i]
-			//foundPattern[i] += sp->intList[index-head];
-			float *bestHit = index;
-			float bestError = fabs( (*index) - isoMass[i]) / isoMass[i];
-			/*check lower adjacent indices*/
-			float *tempIndex = index - 1;
-			while(tempIndex >= head){
-				float ppmError = fabs( (*tempIndex) -
-						isoMass[i])/ isoMass[i];
-				if(ppmError >= ppmCutOff){break;}
-				if(ppmError < bestError){
-					bestHit = tempIndex;
-					bestError = ppmError;
-				}
-				//foundPattern[i] += sp->intList[tempIndex-head];
-				tempIndex--;
-			}
-			/*check higher adjacent indices*/
-			tempIndex = index + 1;
-			while(tempIndex <= tail){
-				float ppmError = fabs( (*tempIndex) -
-					isoMass[i])/ isoMass[i];
-				if(ppmError >= ppmCutOff){break;}
-				if(ppmError < bestError){
-					bestHit = tempIndex;
-					bestError = ppmError;
-				}
-				//foundPattern[i] += sp->intList[tempIndex-head];
-				tempIndex++;
+	/*observed mzs are profile points so allow twice the usual error*/
+	int first, last;
+	featureRange(fl, mass, 2*ppmCutOff, &first, &last);
+	if(first == last){
+		return;
+	}
+
+	/*scratch is reused by every peptide the worker searches*/
+	int *ranges = (int *)poolScratch( 2*(last - first)*sizeof(int));
+	if(ranges == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot search features!\n");
+		return;
+	}
+
+	/*an identified peptide elutes near its ms2 centroid, so only features
+	whose apex could hold its ms1 apex or quant window are searched*/
+	double rtWindow = alignWindow > quantWindow ? alignWindow : quantWindow;
+	int rangeCount = 0;
+	for(i = first; i < last; ++i){
+		FeaturePointer fp = fl->features + i;
+		if(package->ms2RT > 0 && fabs(fp->apexRT - package->ms2RT) > rtWindow){
+			continue;
+		}
+		if(fp->charge <= maxCharge && chargeAllowed(pp, fp->charge)){
+			ranges[2*rangeCount] = fp->first - FEATURE_PAD < 0 ?
+				0 : fp->first - FEATURE_PAD;
+			ranges[2*rangeCount+1] = fp->last + FEATURE_PAD + 1 >
+				xs->scanCount ? xs->scanCount : fp->last + FEATURE_PAD + 1;
+			rangeCount++;
+		}
+	}
+
+	/*merge overlapping ranges so each scan is searched once*/
+	qsort(ranges, rangeCount, 2*sizeof(int), compareRange);
+	int merged = 0;
+	int longest = 0;
+	for(i = 0; i < rangeCount; i = j){
+		int rangeLast = ranges[2*i+1];
+		for(j = i + 1; j < rangeCount && ranges[2*j] <= rangeLast; ++j){
+			if(ranges[2*j+1] > rangeLast){
+				rangeLast = ranges[2*j+1];
 			}
+		}
+		ranges[2*merged] = ranges[2*i];
+		ranges[2*merged+1] = rangeLast;
+		if(rangeLast - ranges[2*i] > longest){
+			longest = rangeLast - ranges[2*i];
+		}
+		merged++;
+	}
+	if(merged == 0){
+		return;
+	}
 
+	/*the traces follow the ranges in the same scratch, which keeps them*/
+	ranges = (int *)poolScratch( 2*merged*sizeof(int) +
+		TRACE_FLOATS(longest)*sizeof(float));
+	if(ranges == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot search features!\n");
+		return;
+	}
+	float *traces = (float *)(ranges + 2*merged);
+	for(i = 0; i < merged; ++i){
+		searchTraces(package, ranges[2*i], ranges[2*i+1], traces);
+	}
+}
 
-			if(sp->intList[bestHit-head] < 0.001){
-				//look left
-				float *tempLindex = bestHit-1;
-				float ppmLerror = 1;
-				while((tempLindex >= head) &&
-					(ppmLerror = fabs( (*tempLindex) - isoMass[i])/ isoMass[i]) <= ppmCutOff &&
-					(sp->intList[tempLindex-head] < 0.001)){
 
-					--tempLindex;
-				}
-				float *tempRindex = bestHit+1;
-				float ppmRerror = 1;
-				while((tempRindex <= tail) &&
-					(ppmRerror = fabs( (*tempRindex) - isoMass[i])/ isoMass[i]) <= ppmCutOff &&
-					(sp->intList[tempRindex-head] < 0.001)){
+void recordHit(SpectraPackagePointer package, int scanNum, float *intensity,
+	float *corr){
+	if(bufferHit(package->hits, maxCharge - MIN_CHARGE + 1, scanNum,
+		intensity, corr)){
+		exit(1);
+	}
+	return;
+}
 
-					++tempRindex;
-				}
-				bestHit = ppmLerror < ppmRerror ? tempLindex : tempRindex;
-			}
 
-			// I have found the most precise recorded mz within the
-			// theoretical window. If at least part of the peak falls here
-			// then sum that peak.
-			float *bestInt = sp->intList+(bestHit-head);
-			if(sp->intList[bestHit-head] > 0){
-				tempIndex = bestInt;
-				if( *tempIndex < *(tempIndex+1)){
-					while(*(tempIndex-1) < *tempIndex){
-						--tempIndex;
-					}
-					foundPattern[i] += sumPeak(tempIndex, sp, 1, seq, filename, sp->scanNum);
-				}else if(*tempIndex > *(tempIndex+1)){
-					while(*(tempIndex+1) < *tempIndex){
-						++tempIndex;
-					}
-					foundPattern[i] += sumPeak(tempIndex, sp, -1, seq, filename, sp->scanNum);
-				}
-			}
+int compareRange(const void *a, const void *b){
+	return ((int *)a)[0] - ((int *)b)[0];
+}
+
+
+int checkChargeStates(ScanPointer sp, float *foundPattern, float *isoMass,
+	double tolerance){
+	int i;
+	for(i = 0; i < isotopicStates*maxCharge; ++i){	
+		if(isoMass[i] == 0){
+			continue; //charge excluded from search
 		}
+		foundPattern[i] += peakIntensity(isoMass[i], sp->mzList, sp->intList,
+			sp->peaksCount, tolerance);
 	}
+	return patternFound(foundPattern);
+}
+
+
+int patternFound(float *foundPattern){
+	int i, j;
 	for(i = MIN_CHARGE-1; i < maxCharge; ++i){
 		int peaks = 0;
 		for(j = 0; j < isotopicStates; ++j){
@@ -808,21 +938,6 @@ int checkChargeStates(ScanPointer sp, float *foundPattern, float *isoMass, char
 }
 
 
-float *binSearch(float mz, float *head, float *tail){
-	while(head < tail && mz > *head && mz < *tail){
-		float *mid = head + (tail-head)/2; //find middle
-		if(fabs(*mid - mz)/mz < ppmCutOff){
-			return mid;
-		}else if(mz > *mid){
-			head = mid+1;
-		}else{
-			tail= mid-1;
-		}		
-	}
-	return NULL;
-}
-
-
 int checkHit(float *intensity, float *foundPattern, float *corr){
 	int i, j;
 	int valid = 0;
@@ -846,12 +961,45 @@ int checkHit(float *intensity, float *foundPattern, float *corr){
 }
 
 
-void *makePeptideThreadFunc( void *ptr ){
-	PeptidePointer pp = (PeptidePointer)ptr;
-	pp->ip = makePeptide(IPCollection, pp->sequence);
-	sem_post(&exit_sem_t);
-	
-	return NULL;
+void addCharge(PeptidePointer pp, int charge){
+	if(charge > 0 && charge < (int)(8*sizeof(pp->charges))){
+		pp->charges |= 1u << charge;
+	}
+	return;
+}
+
+
+int chargeAllowed(PeptidePointer pp, int charge){
+	if(chargeWindow < 0 || pp->charges == 0){
+		return 1;
+	}
+	int c;
+	for(c = charge - chargeWindow; c <= charge + chargeWindow; ++c){
+		if(c > 0 && c < (int)(8*sizeof(pp->charges)) &&
+			(pp->charges & (1u << c)) ){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+void makePeptideTask(void *ptr, int index, int worker){
+	PeptidePointer pp = ((PeptidePointer *)ptr)[index];
+	int composition[ELEMENT_COUNT];
+	if(pp->codeCount < 0){
+		pp->ip = NULL; //sequence could not be parsed
+	}else if(isotopeModel == CONVOLUTION_MODEL){
+		pp->ip = makePeptidePrefix(IPCollection, prefixStacks[worker],
+			pp->codes, pp->codeCount);
+	}else if(isotopeModel == AVERAGINE_MODEL){
+		peptideComposition(pp->codes, pp->codeCount, composition);
+		pp->ip = makeAveragine(composition);
+	}else{
+		peptideComposition(pp->codes, pp->codeCount, composition);
+		pp->ip = cachedComposition(patternCache, composition);
+	}
+	return;
 }
 
 
@@ -886,16 +1034,6 @@ void sendModsLeft(char *sequence){
 }
 
 
-char *inList(char *filename)
-{
-	for(size_t i=0; i<dataCount; ++i)
-	{
-		if(strstr(dataList[i], filename)) return dataList[i];
-	}
-	return NULL;
-}
-
-
 SpectraFileNodePointer delSpectraFileList(SpectraFileNodePointer sfnp){
 	if(sfnp == NULL){
 		return NULL;
@@ -925,16 +1063,94 @@ void printPeptides(PeptidePointer *pp, int peptideCount){
 }
 
 
-PeptidePointer delPeptideList(PeptidePointer root){
-	while(root != &TNILL){
-		root = rbDelete(root, root);
+PeptideStorePointer newPeptideStore(void){
+	int i;
+	PeptideStorePointer store =
+		(PeptideStorePointer)malloc(sizeof(PeptideStore));
+	if(store == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create peptide store!\n");
+		return NULL;
 	}
-	root = NULL;
-	return root;
+	store->slots = (PeptidePointer *)calloc(STORE_SIZE, sizeof(PeptidePointer));
+	store->hashes = (uint32_t *)malloc(STORE_SIZE * sizeof(uint32_t));
+	if(store->slots == NULL || store->hashes == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create peptide store!\n");
+		free(store->slots);
+		free(store->hashes);
+		free(store);
+		return NULL;
+	}
+	store->size = STORE_SIZE;
+	store->count = 0;
+	store->psms = NULL;
+	store->psmCount = 0;
+	store->psmSize = 0;
+	store->files = newFileRegistry();
+	if(store->files == NULL){
+		store->arenaCount = 0;
+		store->arenas = NULL;
+		return delPeptideStore(store);
+	}
+
+	/*each worker allocates peptides from its own arena*/
+	store->arenaCount = poolSize();
+	store->arenas = (ArenaPointer *)calloc(store->arenaCount,
+		sizeof(ArenaPointer));
+	if(store->arenas == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create peptide store!\n");
+		store->arenaCount = 0;
+		return delPeptideStore(store);
+	}
+	for(i = 0; i < store->arenaCount; ++i){
+		store->arenas[i] = newArena(0);
+		if(store->arenas[i] == NULL){
+			return delPeptideStore(store);
+		}
+	}
+	return store;
+}
+
+
+ArenaPointer storeArena(PeptideStorePointer store){
+	return store->arenas[poolWorker()];
+}
+
+
+PeptideStorePointer delPeptideStore(PeptideStorePointer store){
+	int i;
+	if(store == NULL){
+		return NULL;
+	}
+	for(i = 0; i < store->size; ++i){
+		store->slots[i] = delPeptide(store->slots[i]);
+	}
+	for(i = 0; i < store->arenaCount; ++i){
+		store->arenas[i] = delArena(store->arenas[i]);
+	}
+	free(store->arenas);
+	free(store->psms);
+	store->files = delFileRegistry(store->files);
+	free(store->slots);
+	free(store->hashes);
+	free(store);
+	return NULL;
+}
+
+
+PeptideStorePointer parseMaxQuant(char *filename,
+	PeptideStorePointer store){
+	const char *names[TABLE_FIELDS] = {"Raw file", "Scan number",
+		"Modified sequence", "Charge"};
+	int columns[TABLE_FIELDS] = {0, 2, 9, -1};
+	return parseTable(filename, names[RAW_FIELD], names, columns, ".mzXML",
+		store);
 }
 
 
-PeptidePointer parseMaxQuant(char *filename, PeptidePointer pp){
+PeptideStorePointer parseTable(char *filename, const char *first,
+	const char *names[TABLE_FIELDS], int columns[TABLE_FIELDS],
+	const char *suffix, PeptideStorePointer store){
+	int i;
 
 	if(filename == NULL){
 		fprintf(stderr,
@@ -942,150 +1158,265 @@ PeptidePointer parseMaxQuant(char *filename, PeptidePointer pp){
 		exit(1);
 	}
 
-	/*try to open parseMaxQuant results file*/
-	FILE *fp = fopen(filename, "r");
-	if(fp == NULL){
+	/*try to open the results table*/
+	RecordsPointer rp = newRecords(filename);
+	if(rp == NULL){
 		printf("\nERROR: opening %s\n", filename);
 		exit(1);
-	}else{
-		char line[8096];
-		while ( fgets (line ,8095, fp) != NULL ){
-			int i;
-			char *tokens = strtok(line, "\t");
-			/*first line contains headers and must be skipped*/
-			if(strcmp("Raw file", tokens) ){
-				char *rawFile = NULL;
-				int scanNum = -1;
-				char *sequence = NULL;
-				for(i = 0; i < 10; ++i){
-					if(i == 0){
-						rawFile = tokens;
-					}else if(i == 2){
-						scanNum = atoi(tokens);
-					}else if(i == 9){
-						sequence = tokens;
-					}
-					tokens = strtok(NULL, "\t");
-				}				
-				pp = addPeptide(pp, strcat(rawFile, ".mzXML"), scanNum,
-					sequence);
-				if( (lys && strchr(sequence, 'K')) || //if heavy K and seq has K
-					(arg && strchr(sequence, 'R')) ){ //if heavy R and seq has R
-					sequence[0] = '*'; //mark seq as heavy
-					pp = addPeptide(pp, rawFile, scanNum, sequence);
+	}
+	TableParse tp = {rp, NULL, {0}, suffix, NULL};
+	memcpy(tp.columns, columns, sizeof(tp.columns));
+
+	/*locate fields by name in the header, which is then skipped*/
+	const char *cursor = rp->data;
+	const char *end = rp->data + rp->size;
+	size_t offset = 0;
+	int length;
+	const char *record = nextRecord(&cursor, end, &length);
+	if(record != NULL){
+		int count = 1;
+		for(i = 0; i < length; ++i){
+			count += record[i] == '\t';
+		}
+		Field header[count];
+		count = splitRecord(record, length, '\t', false, header, count);
+		if(count > 0 && fieldIs(header, first)){
+			for(i = 0; i < TABLE_FIELDS; ++i){
+				if(names[i] != NULL){
+					tp.columns[i] = findColumn(header, count, names[i],
+						columns[i]);
 				}
 			}
+			offset = cursor - rp->data;
 		}
-		fclose (fp);     
 	}
-	return pp;
+
+	/*chunks are parsed concurrently and merged in file order*/
+	int chunkCount = chunkRecords(rp, offset, RECORD_CHUNK, &tp.bounds);
+	tp.parts = (PeptideStorePointer *)calloc(chunkCount + 1,
+		sizeof(PeptideStorePointer));
+	if(tp.parts == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot parse results!\n");
+		exit(1);
+	}
+	poolFor(chunkCount, 1, tableTask, &tp);
+	for(i = 0; i < chunkCount; ++i){
+		mergeStore(store, tp.parts[i]);
+	}
+	free(tp.parts);
+	free(tp.bounds);
+	rp = delRecords(rp);
+	return store;
+}
+
+
+void tableTask(void *ptr, int index, int worker){
+	TableParsePointer tp = (TableParsePointer)ptr;
+	PeptideStorePointer part = newPeptideStore();
+	if(part == NULL){
+		exit(1);
+	}
+	int i;
+	int width = 0;
+	for(i = 0; i < TABLE_FIELDS; ++i){
+		if(tp->columns[i] >= width){
+			width = tp->columns[i] + 1;
+		}
+	}
+	Field fields[width];
+	char *rawFile = NULL;
+	char *sequence = NULL;
+	int rawSize = 0;
+	int sequenceSize = 0;
+
+	const char *cursor = tp->rp->data + tp->bounds[index];
+	const char *end = tp->rp->data + tp->bounds[index+1];
+	const char *record;
+	int length;
+	while( (record = nextRecord(&cursor, end, &length)) ){
+		int count = splitRecord(record, length, '\t', false, fields, width);
+		/*blank and short records identify nothing*/
+		if(count <= tp->columns[RAW_FIELD] ||
+			count <= tp->columns[SCAN_FIELD] ||
+			count <= tp->columns[SEQUENCE_FIELD]){
+			continue;
+		}
+		int charge = 0;
+		if(tp->columns[CHARGE_FIELD] >= 0 &&
+			tp->columns[CHARGE_FIELD] < count){
+			charge = fieldInt(fields + tp->columns[CHARGE_FIELD]);
+		}
+		int scanNum = fieldInt(fields + tp->columns[SCAN_FIELD]);
+		fieldString(fields + tp->columns[RAW_FIELD], tp->suffix, &rawFile,
+			&rawSize);
+		fieldString(fields + tp->columns[SEQUENCE_FIELD], NULL, &sequence,
+			&sequenceSize);
+		addPeptide(part, rawFile, scanNum, sequence, charge);
+		if( (lys && strchr(sequence, 'K')) || //if heavy K and seq has K
+			(arg && strchr(sequence, 'R')) ){ //if heavy R and seq has R
+			sequence[0] = '*'; //mark seq as heavy
+			addPeptide(part, rawFile, scanNum, sequence, charge);
+		}
+	}
+	free(rawFile);
+	free(sequence);
+	tp->parts[index] = part;
 }
 
 
-PeptidePointer addPeptide(PeptidePointer root, char *rawFile, int scanNum,
-	char *sequence){
+void addPeptide(PeptideStorePointer store, char *rawFile, int scanNum,
+	char *sequence, int charge){
 
 	if(ignoreModSite){
 		sendModsLeft(sequence);
 	}
 
-	PeptidePointer y = &TNILL;
-	PeptidePointer x = root;	
-	while(x != &TNILL){
-		y = x;
-		if(!strcmp(sequence, x->sequence)){
-			x->spectraFiles = addSpectraFileNode(x->spectraFiles, rawFile,
-			scanNum, NULL, NULL);
-			return root;
-		}else if(strcmp(sequence, x->sequence) < 0){
-			x = x->left;
-		}else{
-			x = x->right;
+	/*files outside a user's data list are not recorded*/
+	int fileId = resolveFile(store->files, rawFile);
+
+	uint32_t hash = hashSequence(sequence);
+	int i = findSlot(store, sequence, hash);
+	PeptidePointer x = store->slots[i];
+	if(x != NULL){
+		if(fileId >= 0){
+			addPsm(store, x, fileId, scanNum);
 		}
+		addCharge(x, charge);
+		return;
 	}
-	PeptidePointer z = newPeptide(rawFile, scanNum, sequence);
-	z->parent = y;
-	if(y == &TNILL){
-		root = z;
-	}else if(strcmp(z->sequence, y->sequence) < 0){
-		y->left = z;
-	}else{
-		y->right = z;
+
+	/*keep at most half the slots full so probes stay short*/
+	if(2 * (store->count + 1) > store->size){
+		if(growStore(store)){
+			exit(1);
+		}
+		i = findSlot(store, sequence, hash);
+	}
+	x = newPeptide(storeArena(store), sequence, charge);
+	if(x == NULL){
+		exit(1);
+	}
+	store->slots[i] = x;
+	store->hashes[i] = hash;
+	store->count++;
+	if(fileId >= 0){
+		addPsm(store, x, fileId, scanNum);
 	}
-	root = rbInsertFixup(root, z);
-	return root;
 }
 
 
-char *stripMods(char *moddedPeptide){
-	char peptideBuffer[ strlen(moddedPeptide) ];
-	int i = 0;
-	int j = 0;
-
-	while(j < strlen(moddedPeptide) ){
-		if(strchr(AMINO_ACIDS, moddedPeptide[i])){
-			peptideBuffer[j] = moddedPeptide[i];
-			j++;
-			i++;
-		}else if(moddedPeptide[i] == '\0'){
-			/*Pad end of the buffer with NULL to be safe*/
-			peptideBuffer[j] = '\0';
-			j++;
-		}else{
-			/*Assume anything not NULL or AA is a mod*/
-			i++;
+void addPsm(PeptideStorePointer store, PeptidePointer pp, int fileId,
+	int scanNum){
+	if(store->psmCount == store->psmSize){
+		int size = store->psmSize ? 2*store->psmSize : STORE_SIZE;
+		PsmPointer psms = (PsmPointer)realloc(store->psms,
+			size * sizeof(Psm));
+		if(psms == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot record PSM!\n");
+			exit(1);
 		}
+		store->psms = psms;
+		store->psmSize = size;
+	}
+	PsmPointer psm = store->psms + store->psmCount++;
+	psm->pep = pp;
+	psm->fileId = fileId;
+	psm->scanNum = scanNum;
+}
+
+
+void removePeptide(PeptideStorePointer store, PeptidePointer pp){
+	int mask = store->size - 1;
+	int i = findSlot(store, pp->sequence, hashSequence(pp->sequence));
+	int j = i;
+	if(store->slots[i] != pp){
+		return;
 	}
-	
-	char *peptide = (char *)malloc( (strlen(peptideBuffer)+1)*sizeof(char) );
-	strncpy(peptide, peptideBuffer, strlen(peptideBuffer));
-	peptide[strlen(peptideBuffer)] = '\0';
 
-	return peptide;
+	/*shift back later peptides of the probe sequence whose home slot does
+	not lie between the hole and themselves*/
+	for(j = (j + 1) & mask; store->slots[j] != NULL; j = (j + 1) & mask){
+		int home = store->hashes[j] & mask;
+		if( ((j - home) & mask) >= ((j - i) & mask) ){
+			store->slots[i] = store->slots[j];
+			store->hashes[i] = store->hashes[j];
+			i = j;
+		}
+	}
+	store->slots[i] = NULL;
+	store->count--;
+	pp->row = -1;
+	pp = delPeptide(pp);
 }
 
 
-PeptidePointer initIsotopicPatterns(PeptidePointer root,
+void initIsotopicPatterns(PeptideStorePointer store,
 	PeptidePointer *peptides, int peptideCount){
 
 	int i;
-	sem_unlink("exit_sem_t");
-	sem_init (&exit_sem_t, 0, threadCount);
-  	pthread_attr_t attr;
- 	pthread_attr_init (&attr);
- 	pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
-
-	/*init isotopic pattern collection*/
-	IPCollection = (IsotopicPatternPointer*)
-		malloc(COLLECTION_SIZE * sizeof(IsotopicPatternPointer));
-	newIPCollection(&IPCollection);
-	/*calculate isotopic pattern for each peptide*/
 
-	for(i = 0; i < peptideCount; i++){
-		sem_wait (&exit_sem_t);
-		pthread_t thread;
-		pthread_create( &thread, &attr, makePeptideThreadFunc,
-			(void *)peptides[i]);
-	}
-	for(i = 0; i < threadCount; i++){
-		sem_wait (&exit_sem_t);
+	/*init isotopic pattern collection, only convolution builds on it*/
+	if(isotopeModel == CONVOLUTION_MODEL){
+		IPCollection = (IsotopicPatternPointer*)
+			malloc(COLLECTION_SIZE * sizeof(IsotopicPatternPointer));
+		newIPCollection(&IPCollection);
+
+		/*peptides are sorted, so those a worker takes in turn share prefixes
+		whose patterns it keeps*/
+		prefixStacks = (PrefixStackPointer *)malloc(poolSize() *
+			sizeof(PrefixStackPointer));
+		if(prefixStacks == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot make patterns!\n");
+			exit(1);
+		}
+		for(i = 0; i < poolSize(); ++i){
+			prefixStacks[i] = newPrefixStack();
+			if(prefixStacks[i] == NULL){
+				exit(1);
+			}
+		}
+	}else if(isotopeModel == AVERAGINE_MODEL){
+		initAveragine();
+	}else{
+		/*peptides sharing a composition share a pattern*/
+		patternCache = newPatternCache();
+		if(patternCache == NULL){
+			exit(1);
+		}
+		if(isotopeCache != NULL){
+			printf("\tRead %d cached isotopic patterns.\n",
+				readPatternCache(patternCache, isotopeCache));
+		}
 	}
+	/*calculate isotopic pattern for each peptide*/
+
+	poolFor(peptideCount, PREFIX_CHUNK, makePeptideTask, (void *)peptides);
 
-	sem_destroy(&exit_sem_t);
 	/*delete isotopic pattern collection*/
 	
 	for(i = 0; i < peptideCount; i++){
 		if(peptides[i]->ip == NULL){/*happens if ip generation failed*/
-			root = rbDelete(root, peptides[i]);
+			removePeptide(store, peptides[i]);
 		}
 	}
 	IPCollection = delIPCollection(IPCollection);
-		
-	return root;
+	if(prefixStacks != NULL){
+		for(i = 0; i < poolSize(); ++i){
+			prefixStacks[i] = delPrefixStack(prefixStacks[i]);
+		}
+		free(prefixStacks);
+		prefixStacks = NULL;
+	}
+	if(patternCache != NULL && isotopeCache != NULL){
+		writePatternCache(patternCache, isotopeCache);
+	}
+	patternCache = delPatternCache(patternCache);
 }
 
 
-void printSearchResults(PeptidePointer *peptides, int peptideCount){
+void printSearchResults(PeptidePointer *peptides, int peptideCount,
+	SpectraFileNodePointer filelist, HitStorePointer ms2hits,
+	HitStorePointer ms1hits){
 
 	FILE *fp = fopen("searchResults.txt", "w");
 	if (fp == NULL)
@@ -1100,39 +1431,60 @@ void printSearchResults(PeptidePointer *peptides, int peptideCount){
    		 printf("Error opening file!\n");
    		 exit(1);
 	}
-	int i;
+	/*runs name files by their filelist column*/
+	int fileCount = 0;
+	SpectraFileNodePointer sfnp;
+	for(sfnp = filelist; sfnp != NULL; sfnp = sfnp->next){
+		fileCount++;
+	}
+	char **names = (char **)malloc( (fileCount + 1) * sizeof(char *));
+	if(names == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot print results!\n");
+		exit(1);
+	}
+	int i, j, k, u, h;
+	for(i = 0, sfnp = filelist; sfnp != NULL; ++i, sfnp = sfnp->next){
+		names[i] = sfnp->rawFile;
+	}
+
+	int width = ms1hits->width;
 	for(i = 0; i < peptideCount; ++i){
+		int row = peptides[i]->row;
 		fprintf(fp, "sequence: %s\n", peptides[i]->sequence);
 		fprintf(fp2, "sequence: %s\n", peptides[i]->sequence);
-		SpectraFileNodePointer sfnp = peptides[i]->ms1SpectraFiles;
+		/*print ms1 summary info, scans are not kept when streaming*/
+		if(peptides[i]->ms1Summaries != NULL){
+			for(j = 0; j < fileCount; ++j){
+				Ms1SummaryPointer ms = peptides[i]->ms1Summaries + j;
+				if(ms->hits){
+					fprintf(fp, "\t%s\n\t\t%d hits\t%.4e\t|apex - %.2e|\n",
+						names[j], ms->hits, ms->apexRT, ms->apexIntensity);
+				}
+			}
+		}
 		/*print ms1 info*/
-		while(sfnp != NULL){
-			fprintf(fp, "\t%s\n", sfnp->rawFile);
-			ScanNodePointer snp = sfnp->scans;
-			while(snp != NULL){
-				fprintf(fp, "\t\t%d\t%.4e\t", snp->scanNum, snp->rt);
-				int j;
-				for(j = 0; j < maxCharge - MIN_CHARGE + 1; j++){
-					fprintf(fp, "|%.2f - %.2e|\t", snp->corr[j],
-						snp->intensity[j]);
+		for(u = ms1hits->runStart[row]; u < ms1hits->runStart[row+1]; ++u){
+			fprintf(fp, "\t%s\n", names[ms1hits->runColumn[u]]);
+			for(h = ms1hits->hitStart[u]; h < ms1hits->hitStart[u+1]; ++h){
+				fprintf(fp, "\t\t%d\t%.4e\t", ms1hits->scanNum[h],
+					ms1hits->rt[h]);
+				for(k = 0; k < width; k++){
+					fprintf(fp, "|%.2f - %.2e|\t", ms1hits->corr[h*width + k],
+						ms1hits->intensity[h*width + k]);
 				}
 				fprintf(fp, "\n");
-				snp = snp->next;
 			}
-			sfnp = sfnp->next;
 		}
 		/*print ms2 info*/
-		sfnp = peptides[i]->spectraFiles;
-		while(sfnp != NULL){
-			fprintf(fp2, "\t%s\n", sfnp->rawFile);
-			ScanNodePointer snp = sfnp->scans;
-			while(snp != NULL){
-				fprintf(fp2, "\t\t%d\t%.4e\n", snp->scanNum, snp->rt);
-				snp = snp->next;
+		for(u = ms2hits->runStart[row]; u < ms2hits->runStart[row+1]; ++u){
+			fprintf(fp2, "\t%s\n", names[ms2hits->runColumn[u]]);
+			for(h = ms2hits->hitStart[u]; h < ms2hits->hitStart[u+1]; ++h){
+				fprintf(fp2, "\t\t%d\t%.4e\n", ms2hits->scanNum[h],
+					ms2hits->rt[h]);
 			}
-			sfnp = sfnp->next;
 		}
 	}
+	free(names);
 	fclose(fp);
 	fclose(fp2);
 	return;
@@ -1140,7 +1492,7 @@ void printSearchResults(PeptidePointer *peptides, int peptideCount){
 
 
 void printTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **table, char *filename){
+	int peptideCount, int fileCount, MatrixPointer table, char *filename){
 
 	FILE *fp = fopen(filename, "w");
 	if (fp == NULL)	{
@@ -1157,8 +1509,9 @@ void printTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
 	int j;
 	for(i = 0; i < peptideCount; ++i){
 		fprintf(fp, "%s", peptides[i]->sequence);
+		double *row = matrixRow(table, i);
 		for(j = 0; j < fileCount; ++j){
-			fprintf(fp, "\t%.6e", table[i][j]);
+			fprintf(fp, "\t%.6e", row[j]);
 		}
 		fprintf(fp, "\n");
 	}
@@ -1168,7 +1521,7 @@ void printTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
 
 
 void printPepTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
-	int peptideCount, int fileCount, double **table, char *filename,
+	int peptideCount, int fileCount, MatrixPointer table, char *filename,
 	char **proteinMap){
 
 	FILE *fp = fopen(filename, "w");
@@ -1186,8 +1539,9 @@ void printPepTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
 	int j;
 	for(i = 0; i < peptideCount; ++i){
 		fprintf(fp, "%s", peptides[i]->sequence);
+		double *row = matrixRow(table, i);
 		for(j = 0; j < fileCount; ++j){
-			fprintf(fp, "\t%.6e", table[i][j]);
+			fprintf(fp, "\t%.6e", row[j]);
 		}
 		fprintf(fp, "\t%s\n", proteinMap[i]==NULL? "" : proteinMap[i]);
 	}
@@ -1196,138 +1550,290 @@ void printPepTable(PeptidePointer *peptides, SpectraFileNodePointer filelist,
 }
 
 
-void searchMzXMLs(PeptidePointer *peptides, int peptideCount,
-	SpectraFileNodePointer filelist){
+HitStorePointer searchMzXMLs(HitStorePointer ms2hits,
+	PeptidePointer *peptides, int peptideCount,
+	SpectraFileNodePointer filelist, MZXMLPointer first){
 
 	int i, j;
+	int fileCount = 0;
+	SpectraFileNodePointer sfnp;
+	for(sfnp = filelist; sfnp != NULL; sfnp = sfnp->next){
+		fileCount++;
+	}
+
+	/* when streaming hits are folded into one summary per file */
+	if(streaming){
+		for(j = 0; j < peptideCount; ++j){
+			peptides[j]->ms1Summaries = newMs1Summaries(fileCount);
+			if(peptides[j]->ms1Summaries == NULL){
+				exit(1);
+			}
+		}
+	}
+
+	SpectraFileNodePointer *files = (SpectraFileNodePointer *)malloc(
+		(fileCount + 1) * sizeof(SpectraFileNodePointer));
+	FileCostPointer order = (FileCostPointer)malloc(
+		(fileCount + 1) * sizeof(FileCost));
+	int *wave = (int *)malloc( (fileCount + 1) * sizeof(int));
+	pthread_mutex_t *hitLocks = (pthread_mutex_t *)malloc(
+		HIT_STRIPES * sizeof(pthread_mutex_t));
+	HitStorePointer *ms1hits = (HitStorePointer *)calloc(fileCount + 1,
+		sizeof(HitStorePointer));
+	if(files == NULL || order == NULL || wave == NULL || hitLocks == NULL ||
+		ms1hits == NULL){
+		fprintf(stderr,
+			"\nERROR: Out of memory - cannot search mzXML files!\n");
+		exit(1);
+	}
+	for(i = 0; i < HIT_STRIPES; ++i){
+		pthread_mutex_init(hitLocks + i, NULL);
+	}
+
+	/*the charges found in ms2 scans of earlier files restrict the search of
+	later files, so charge restricted searches keep the filelist order*/
+	bool concurrent = memBudget > 0 && chargeWindow < 0;
+	for(i = 0, sfnp = filelist; sfnp != NULL; ++i, sfnp = sfnp->next){
+		files[i] = sfnp;
+		order[i].index = i;
+		order[i].footprint = concurrent? fileFootprint(sfnp->rawFile) : 0;
+	}
+	/*largest files first so the last wave is not held up by a large file*/
+	if(concurrent){
+		qsort(order, fileCount, sizeof(FileCost), compareFileCost);
+	}
+	/*a prefetched first file is already held, so it joins the first wave
+	and counts against its budget*/
+	if(concurrent && first != NULL){
+		i = 0;
+		while(order[i].index != 0){
+			++i;
+		}
+		FileCost prefetched = order[i];
+		memmove(order + 1, order, i * sizeof(FileCost));
+		order[0] = prefetched;
+	}
+
+	FileSearch search = {peptides, peptideCount, files, wave, first,
+		hitLocks, ms2hits, ms1hits};
+	double budget = (double)memBudget * 1024 * 1024;
+	int next = 0;
+	while(next < fileCount){
+		/*admit files until the budget is spent, always at least one*/
+		int count = 0;
+		double used = 0;
+		do{
+			wave[count++] = order[next].index;
+			used += order[next].footprint;
+			next++;
+		}while(concurrent && next < fileCount &&
+			used + order[next].footprint <= budget);
+		poolFor(count, 1, searchFile, (void *)&search);
+	}
+
+	for(i = 0; i < HIT_STRIPES; ++i){
+		pthread_mutex_destroy(hitLocks + i);
+	}
+	free(hitLocks);
+	free(wave);
+	free(order);
+	free(files);
+
+	/*join the hits of each file into one store by peptide row*/
+	HitStorePointer hits = mergeHits(ms1hits, fileCount, peptideCount,
+		maxCharge - MIN_CHARGE + 1, true);
+	free(ms1hits);
+	return hits;
+}
+
+
+void searchFile(void *ptr, int index, int worker){
+	FileSearchPointer fs = (FileSearchPointer)ptr;
+	PeptidePointer *peptides = fs->peptides;
+	int peptideCount = fs->peptideCount;
+	int fileIndex = fs->wave[index];
+	SpectraFileNodePointer filelist = fs->files[fileIndex];
+	int j;
+
+	time_t start, end;
+	time(&start);
+
+	/*read mzXML*/
+	MZXMLPointer mzXML = (fileIndex == 0)? fs->first : NULL;
+	if(mzXML == NULL){
+		readMZXML(filelist->rawFile, &mzXML);
+	}
+	printf("\tFile: %s read %d spectra\n",
+	filelist->rawFile, mzXML->scanCount);
+
 	/* prepare packages for threaded spectra search */
 	SpectraPackagePointer *packages = malloc(peptideCount * 
 		sizeof(SpectraPackagePointer));
-	
-	if(packages == NULL){
-		fprintf(stderr, "ERROR\n");
+	SpectraPackagePointer store = malloc(peptideCount *
+		sizeof(SpectraPackage));
+	HitBufferPointer buffers = (HitBufferPointer)calloc(peptideCount + 1,
+		sizeof(HitBuffer));
+	if(packages == NULL || store == NULL || buffers == NULL){
+		fprintf(stderr,
+			"ERROR: could not allocated memory for spectra search\n");
 		exit(1);
-	}else{
-		for(j = 0; j < peptideCount; ++j){	
-			packages[j] = malloc(sizeof(SpectraPackage));
-			if(packages[j] == NULL){
-				fprintf(stderr,
-					"ERROR: could not allocated memory for spectra search\n");
-				exit(1);
-			}
-		}
-		while(filelist != NULL){
+	}
 
-			sem_unlink("exit_sem_t");
-			sem_init (&exit_sem_t, 0, threadCount);
-		  	pthread_attr_t attr;
-		 	pthread_attr_init (&attr);
-		 	pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+	/*copy ms1 peaks into a single store to detect features in and extract
+	the chromatograms of matching features from*/
+	XicStorePointer xs = useFeatures? newXicStore(mzXML) : NULL;
+	FeatureListPointer fl = useFeatures?
+		findFeatures(xs, filelist->rawFile) : NULL;
+
+	/*get ms2 retention time, tic and precursor charge info. Charges
+	are needed before the search if it is charge restricted*/
+	HitStorePointer ms2hits = fs->ms2hits;
+	for(j = 0; j < peptideCount; ++j){
+		store[j].ms2RT = 0;
+		int run = findRun(ms2hits, peptides[j]->row, fileIndex);
+		if(run < 0){
+			continue;
+		}
+		pthread_mutex_t *hitLock = fs->hitLocks + j % HIT_STRIPES;
+		pthread_mutex_lock(hitLock);
+		int h;
+		for(h = ms2hits->hitStart[run]; h < ms2hits->hitStart[run+1]; ++h){
+			ScanPointer sp = mzXML->scans[ms2hits->scanNum[h]-1];
+			ms2hits->rt[h] = sp->retentionTime;
+			addCharge(peptides[j], sp->precCharge);
+
+			/* ms2 hits have a single intensity, the TIC*/
+			ms2hits->intensity[h] = sp->totalIonCurrent;
+		}
 
-			time_t start, end;
-			time(&start);
-	
-			/*read mzXML*/
-			MZXMLPointer mzXML;
-			
-			readMZXML(filelist->rawFile, &mzXML);
-			printf("\tFile: %s read %d spectra\n",
-			filelist->rawFile, mzXML->scanCount);
-
-			/*search mzXML for isotopic patterns*/
-			for(j = 0; j < peptideCount; ++j){
-				packages[j]->mzXML = mzXML;
-				packages[j]->pep = peptides[j];	
-				sem_wait (&exit_sem_t);
-				pthread_t thread;
-				pthread_create( &thread, &attr, (void*)&searchSpectra,
-					(void*) packages[j]);
-			}
-	
-			for(i=0; i<threadCount; i++){	
-				sem_wait (&exit_sem_t);
+		/*the quant window of an identified peptide is centred on its ms2
+		centroid unless its ms1 apex is close, so features are matched
+		near it and a streamed summary keeps the window about it exactly
+		as well as the apex's*/
+		double totalIntensity = 0;
+		double weightedCentroid = 0;
+		for(h = ms2hits->hitStart[run]; h < ms2hits->hitStart[run+1]; ++h){
+			totalIntensity+=ms2hits->intensity[h];
+		}
+		for(h = ms2hits->hitStart[run]; h < ms2hits->hitStart[run+1]; ++h){
+			weightedCentroid+=
+				(ms2hits->intensity[h]*ms2hits->rt[h])/totalIntensity;
+		}
+		if(totalIntensity > 0){
+			store[j].ms2RT = weightedCentroid;
+			if(peptides[j]->ms1Summaries != NULL){
+				anchorSummary(peptides[j]->ms1Summaries + fileIndex,
+					weightedCentroid);
 			}
-
-			/*get ms1 and ms2 retention time info*/
-			for(j = 0; j < peptideCount; ++j){
-				SpectraFileNodePointer sfnp = peptides[j]->ms1SpectraFiles;
-				while(sfnp != NULL){
-					if(!strcmp(sfnp->rawFile, mzXML->filename) ){
-						ScanNodePointer snp = sfnp->scans;
-						while(snp != NULL){
-							snp->rt = 
-								mzXML->scans[snp->scanNum-1]->retentionTime;
-							snp = snp->next;
-						}
-						break;
-					}
-					sfnp = sfnp->next;
-				}
-				sfnp = peptides[j]->spectraFiles;
-				while(sfnp != NULL){
-					if(!strcmp(sfnp->rawFile, mzXML->filename) ){
-						ScanNodePointer snp = sfnp->scans;
-						while(snp != NULL){
-							snp->rt = 
-								mzXML->scans[snp->scanNum-1]->retentionTime;
-
-							/* since we are not using snp->intensity for
-							   ms2 scans lets use it to store TIC*/
-							snp->intensity = (float*)malloc(sizeof(float));
-							if(snp->intensity == NULL){
-								fprintf(stderr,
-								"Error allocating memory for ms2 tic info\n");
-							}else{
-								snp->intensity[0] =
-									mzXML->scans[snp->scanNum-1]
-										->totalIonCurrent;
-								snp = snp->next;
-							}
-						}
-						break;
-					}
-					sfnp = sfnp->next;
-				}
-			}	
-			delMZXML(mzXML);
-			time(&end);
-			printf("took %f seconds\n", difftime(end, start));
-			filelist = filelist->next;
-			sem_destroy(&exit_sem_t);
 		}
-	}	
-	/* recover memory allocated for packages */
-	for(j = 0; j < peptideCount; ++j){	
-			free(packages[j]);
-			packages[j] = NULL;
+		pthread_mutex_unlock(hitLock);
+	}
+
+	/*fit the m/z error of identified precursors to search with a
+	corrected m/z and tighter tolerance*/
+	CalibrationPointer cal = recalibrate? newCalibration(mzXML, ms2hits,
+		fileIndex, peptides, peptideCount) : NULL;
+
+	/*search mzXML for isotopic patterns*/
+	for(j = 0; j < peptideCount; ++j){
+		packages[j] = store + j;
+		packages[j]->mzXML = mzXML;
+		packages[j]->xic = xs;
+		packages[j]->features = fl;
+		packages[j]->cal = cal;
+		packages[j]->fileIndex = fileIndex;
+		packages[j]->hits = buffers + peptides[j]->row;
+		packages[j]->pep = peptides[j];	
+	}
+	poolFor(peptideCount, 0, searchSpectra, (void *)packages);
+
+	/*pack the file's ms1 hits and get their retention time info*/
+	HitStorePointer hits = bufferedHits(buffers, peptideCount, fileIndex,
+		maxCharge - MIN_CHARGE + 1);
+	if(hits == NULL){
+		exit(1);
 	}
+	for(j = 0; j < hits->hitCount; ++j){
+		hits->rt[j] = mzXML->scans[hits->scanNum[j]-1]->retentionTime;
+	}
+	fs->ms1hits[fileIndex] = hits;
+	cal = delCalibration(cal);
+	fl = delFeatureList(fl);
+	xs = delXicStore(xs);
+	delMZXML(mzXML);
+	free(buffers);
+	free(store);
 	free(packages);
+	time(&end);
+	printf("\tFile: %s took %f seconds\n", filelist->rawFile,
+		difftime(end, start));
+	return;
+}
+
+
+double fileFootprint(char *filename){
+	struct stat fileStat;
+	if(stat(filename, &fileStat)){
+		return 0;
+	}
+	return (double)fileStat.st_size * MZXML_FOOTPRINT;
+}
+
+
+int compareFileCost(const void *a, const void *b){
+	FileCostPointer x = (FileCostPointer)a;
+	FileCostPointer y = (FileCostPointer)b;
+	if(x->footprint != y->footprint){
+		return x->footprint < y->footprint ? 1 : -1;
+	}
+	return x->index - y->index;
 }
 
-int initFilelist(SpectraFileNodePointer *filelist, PeptidePointer *peptides,
-	int peptideCount){
+SpectraFileNodePointer newFilelist(PeptideStorePointer store,
+	PeptidePointer *peptides, int peptideCount){
 
 	SpectraFileNodePointer root = NULL;
+	FileRegistryPointer files = store->files;
 	int i;
 
+	/*PSMs of removed peptides keep a row of -1*/
 	for(i = 0; i < peptideCount; ++i){
-		SpectraFileNodePointer sfnp = peptides[i]->spectraFiles;
-		while(sfnp){
-			root = addSpectraFileNode(root,
-				sfnp->rawFile, 0, NULL, NULL);
-			sfnp = sfnp->next;
+		peptides[i]->row = i;
+	}
+	bool *seen = (bool *)calloc(files->count + 1, sizeof(bool));
+	if(seen == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot list files!\n");
+		exit(1);
+	}
+	for(i = 0; i < store->psmCount; ++i){
+		if(store->psms[i].pep->row >= 0){
+			seen[store->psms[i].fileId] = true;
 		}
 	}
+	for(i = 0; i < files->count; ++i){
+		if(seen[i]){
+			root = addSpectraFileNode(root, i, fileName(files, i));
+		}
+	}
+	free(seen);
 
 	// if user specified a list of data files ensure they are all included
 	if (dataList)
 	{
 		for (i=0; i<dataCount; ++i)
 		{
-			root = addSpectraFileNode(root, dataList[i], 0, NULL, NULL);
+			int id = internFile(files, dataList[i]);
+			root = addSpectraFileNode(root, id, fileName(files, id));
 		}
 	}
+	return root;
+}
+
 
+int initFilelist(SpectraFileNodePointer *filelist, PeptideStorePointer store,
+	PeptidePointer *peptides, int peptideCount){
+
+	SpectraFileNodePointer root = newFilelist(store, peptides, peptideCount);
 	(*filelist) = root;
 	int fileCount = 0;
 	while(root != NULL){
@@ -1339,7 +1845,45 @@ int initFilelist(SpectraFileNodePointer *filelist, PeptidePointer *peptides,
 }
 
 
-PeptidePointer parseStatQuest(char *filename, PeptidePointer pp){
+int *fileColumns(FileRegistryPointer files, SpectraFileNodePointer filelist){
+	int i;
+	int *columns = (int *)malloc( (files->count + 1) * sizeof(int));
+	if(columns == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot index files!\n");
+		return NULL;
+	}
+	for(i = 0; i < files->count; ++i){
+		columns[i] = -1;
+	}
+	for(i = 0; filelist != NULL; ++i, filelist = filelist->next){
+		columns[filelist->fileId] = i;
+	}
+	return columns;
+}
+
+
+HitStorePointer psmHits(PeptideStorePointer store, int *columns,
+	int rowCount){
+	int i;
+	HitKeyPointer keys = (HitKeyPointer)malloc(
+		(store->psmCount + 1) * sizeof(HitKey));
+	if(keys == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot index PSMs!\n");
+		return NULL;
+	}
+	for(i = 0; i < store->psmCount; ++i){
+		keys[i].row = store->psms[i].pep->row;
+		keys[i].column = columns[store->psms[i].fileId];
+		keys[i].scanNum = store->psms[i].scanNum;
+	}
+	HitStorePointer hs = keyedHits(keys, store->psmCount, rowCount);
+	free(keys);
+	return hs;
+}
+
+
+PeptideStorePointer parseStatQuest(char *filename,
+	PeptideStorePointer store){
 
 	if(filename == NULL){
 		fprintf(stderr,
@@ -1348,75 +1892,99 @@ PeptidePointer parseStatQuest(char *filename, PeptidePointer pp){
 	}
 
 	/*try to open StatQuest file*/
-	FILE *fp = fopen(filename, "r");
-	if(fp == NULL){
+	RecordsPointer rp = newRecords(filename);
+	if(rp == NULL){
 		printf("Error opening %s\n", filename);
 		exit(1);
-	}else{
-		char line[4096];
-		while ( fgets (line ,4095, fp) != NULL ){
-				int i;
-				char *spectra = NULL;
-				char *sequence = NULL;
-				char *tokens = strtok(line, " ");
-				for(i = 0; i < 13; ++i){
-					if(i == 1){
-						spectra = tokens;
-					}else if(i == 12){
-						sequence = tokens;
-						if(sequence[0] == '+'){
-							tokens = strtok(NULL, " ");
-							sequence = tokens;
-						}
-						char *firstPeriod = strchr(sequence, '.');
-						char *secondPeriod = strrchr(sequence, '.');
-						if(firstPeriod != secondPeriod){
-							*(secondPeriod+1) = '_';
-						}
-						*(firstPeriod-1) = '_';
-						*(strchr(sequence, '\n')-1) = '\0';
-					}
-					tokens = strtok(NULL, " ");
-				}				
-				tokens = strtok(spectra, ".");
-				char*rawFile;
-				int scanNum = -1;
-				for(i = 0; i < 2; ++i){
-					if(i == 0){
-						rawFile = tokens;
-					}else if(i == 1){
-						scanNum = atoi(tokens);
-					}
-					tokens = strtok(NULL, " ");
-				}		
+	}
+
+	Field fields[14];
+	char *rawFile = NULL;
+	char *sequence = NULL;
+	int rawSize = 0;
+	int sequenceSize = 0;
+	const char *cursor = rp->data;
+	const char *end = rp->data + rp->size;
+	const char *record;
+	int length;
+	while( (record = nextRecord(&cursor, end, &length)) ){
+		int count = splitRecord(record, length, ' ', true, fields, 14);
+		if(count < 13 || (fields[12].start[0] == '+' && count < 14)){
+			continue;
+		}
 
-				pp = addPeptide(pp, strcat(rawFile, ".mzXML"), scanNum,
-					sequence);
+		/*spectra are named raw.startScan.endScan.charge*/
+		Field spectra = fields[1];
+		const char *firstPeriod = (const char *)memchr(spectra.start, '.',
+			spectra.length);
+		if(firstPeriod == NULL){
+			continue;
+		}
+		const char *lastPeriod = firstPeriod;
+		const char *c;
+		for(c = firstPeriod; c < spectra.start + spectra.length; ++c){
+			if(*c == '.'){
+				lastPeriod = c;
+			}
+		}
+		int charge = 0;
+		if(lastPeriod != firstPeriod){
+			Field chargeField = {lastPeriod + 1,
+				(int)(spectra.start + spectra.length - lastPeriod - 1)};
+			charge = fieldInt(&chargeField);
+		}
+		Field scanField = {firstPeriod + 1,
+			(int)(spectra.start + spectra.length - firstPeriod - 1)};
+		Field rawField = {spectra.start, (int)(firstPeriod - spectra.start)};
+		fieldString(&rawField, ".mzXML", &rawFile, &rawSize);
+
+		/*flanking residues of prev.SEQUENCE.next are replaced by _*/
+		fieldString(fields + (fields[12].start[0] == '+' ? 13 : 12), NULL,
+			&sequence, &sequenceSize);
+		char *firstDot = strchr(sequence, '.');
+		char *secondDot = strrchr(sequence, '.');
+		if(firstDot != secondDot && secondDot[1] != '\0'){
+			*(secondDot+1) = '_';
+		}
+		if(firstDot != NULL && firstDot != sequence){
+			*(firstDot-1) = '_';
 		}
-		fclose (fp);     
+
+		addPeptide(store, rawFile, fieldInt(&scanField), sequence, charge);
 	}
-	return pp;
+	free(rawFile);
+	free(sequence);
+	rp = delRecords(rp);
+	return store;
 }
 
 
-int getCount(PeptidePointer root){
-	if(root == &TNILL){
-		return 0;
-	}else{
-		return(getCount(root->left) + 1 + getCount(root->right));
-	}	
+int getCount(PeptideStorePointer store){
+	return store->count;
 }
 
 
-PeptidePointer *inOrder(PeptidePointer root, int count){
+PeptidePointer *inOrder(PeptideStorePointer store, int count){
+	int i;
+	int j = 0;
 	PeptidePointer *peptides = (PeptidePointer *)
 		malloc(count * sizeof(PeptidePointer));
-	fillPeptides(root, 0, peptides);
+	if(peptides == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot order peptides!\n");
+		exit(1);
+	}
+	for(i = 0; i < store->size && j < count; ++i){
+		if(store->slots[i] != NULL){
+			peptides[j++] = store->slots[i];
+		}
+	}
+	sortPeptides(peptides, j);
 	return peptides;
 }
 
 
-PeptidePointer parseStatQuestdir(char *dirName, int cutoff){
+PeptideStorePointer parseStatQuestdir(char *dirName, int cutoff,
+	PeptideStorePointer store){
 
 	if(cutoff <= 0 || cutoff >= 100){
 		fprintf(stderr, 
@@ -1426,20 +1994,28 @@ PeptidePointer parseStatQuestdir(char *dirName, int cutoff){
 	
 	DIR *dp;
 	dp = opendir(dirName);
-	PeptidePointer pp = &TNILL;	
 	
+	char **paths = NULL;
+	int count = 0;
 	if(dp != NULL){
 		struct dirent *ep = NULL;
-		char suffix[strlen(STATQUEST_EXT)+2];
+		char suffix[strlen(STATQUEST_EXT)+3]; //two digits and the NUL
 		sprintf(suffix, "%02d%s", cutoff, STATQUEST_EXT);
 		while ( (ep = readdir (dp)) ){
 			if(strstr(ep->d_name, suffix)){
 				puts(ep->d_name);
-				char fullPath[strlen(dirName) + strlen(ep->d_name) + 2];
+				paths = (char **)realloc(paths, (count+1) * sizeof(char *));
+				char *fullPath = (char *)malloc(strlen(dirName) +
+					strlen(ep->d_name) + 2);
+				if(paths == NULL || fullPath == NULL){
+					fprintf(stderr,
+						"\nERROR: Out of memory - cannot list %s!\n", dirName);
+					exit(1);
+				}
 				strcpy(fullPath, dirName);
 				strcat(fullPath, "/");
 				strcat(fullPath, ep->d_name);
-				pp = parseStatQuest(fullPath, pp);
+				paths[count++] = fullPath;
 			}
 		}
 		(void) closedir (dp);
@@ -1447,52 +2023,19 @@ PeptidePointer parseStatQuestdir(char *dirName, int cutoff){
 		fprintf(stderr, "\nERROR: Could not open directory: %s!\n", dirName);
 		exit(1);
 	}
-	
-	return pp;
-}
-
-PeptidePointer parseFuse(char *filename, PeptidePointer pp){
 
-	if(filename == NULL){
-		fprintf(stderr,
-			"\nERROR: Could not parse search results. Filename was NULL.\n");
-		exit(1);
+	/*files are parsed concurrently, each into a store of its own*/
+	store = parseFiles(paths, count, parseStatQuest, store);
+	while(count > 0){
+		free(paths[--count]);
 	}
+	free(paths);
+	return store;
+}
 
-	/*try to open parseMaxQuant results file*/
-	FILE *fp = fopen(filename, "r");
-	if(fp == NULL){
-		printf("\nERROR: opening %s\n", filename);
-		exit(1);
-	}else{
-		char line[8096];
-		while ( fgets (line ,8095, fp) != NULL ){
-			int i;
-			char *tokens = strtok(line, "\t");
-			/*first line contains headers and must be skipped*/
-			if(strcmp("Sequence", tokens) ){
-				char *rawFile = NULL;
-				int scanNum = -1;
-				char *sequence = NULL;
-				for(i = 0; i < 3; ++i){
-					if(i == 1){
-						rawFile = tokens;
-					}else if(i == 2){
-						scanNum = atoi(tokens);
-					}else if(i == 0){
-						sequence = tokens;
-					}
-					tokens = strtok(NULL, "\t");
-				}
-				pp = addPeptide(pp, rawFile, scanNum, sequence);
-				if( (lys && strchr(sequence, 'K')) || //if heavy K and seq has K
-					(arg && strchr(sequence, 'R')) ){ //if heavy R and seq has R
-					sequence[0] = '*'; //mark seq as heavy
-					pp = addPeptide(pp, rawFile, scanNum, sequence);
-				}
-			}
-		}
-		fclose (fp);
-	}
-	return pp;
+PeptideStorePointer parseFuse(char *filename, PeptideStorePointer store){
+	const char *names[TABLE_FIELDS] = {"File", "Scan", "Sequence", NULL};
+	int columns[TABLE_FIELDS] = {1, 2, 0, -1};
+	return parseTable(filename, names[SEQUENCE_FIELD], names, columns, NULL,
+		store);
 }
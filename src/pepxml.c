@@ -23,7 +23,9 @@
  */
 
 #include "pepxml.h"
-#include "xml.h" //openXML, downTo, getAttribute 
+#include "xml.h" //downTo, getAttribute 
+
+#include <libxml/xmlreader.h> //xmlTextReader
 
 #include <stdlib.h> //malloc
 #include <string.h> //
@@ -44,6 +46,7 @@
 #define YES "Y"
 #define SPECTRUM_QUERY "spectrum_query"
 #define START_SCAN "start_scan"
+#define ASSUMED_CHARGE "assumed_charge"
 #define SEARCH_RESULT "search_result"
 #define SEARCH_HIT "search_hit"
 #define PEPTIDE "peptide"
@@ -109,20 +112,25 @@ char *convertMod(ModPointer mp, double mass);
 char *modSequence(xmlNodePtr hit, xmlChar *seq, ModPointer mp);
 
 /*
- * getSearchResults - search the msmsRunSummary portion of a pepXML for hits
- *     converting pepXML format hits to MaxQuant like modded sequences. Store
- *     hits in the passed peptide linked list returning the new root of the
- *     linked list.
+ * getSearchResults - convert the rank 1 hits of a single spectrumQuery to
+ *     MaxQuant like modded sequences. Store hits in the passed peptide store
+ *     and return it.
  */
-PeptidePointer getSearchResults(PeptidePointer pp, xmlNodePtr msmsRunSummary,
-	ModPointer mp, char *mzXMLname);
+PeptideStorePointer getSearchResults(PeptideStorePointer store,
+	xmlNodePtr spectrumQuery, ModPointer mp, char *mzXMLname);
 
 /*
- * Given the name of a pepXML, open and parse the pepXML storing the peptide 
- *     information in the passed peptide linked list. Return a pointer to the 
- *     new root of the peptide linked list. 
+ * runName - convert the base_name of a msms_run_summary to the name of the
+ *     mzXML the hits were found in.
  */
-PeptidePointer readPepXML(char *filename, PeptidePointer pp);
+char *runName(xmlChar *base);
+
+/*
+ * Given the name of a pepXML, stream through the pepXML storing the peptide 
+ *     information in the passed peptide store and return it. Only the
+ *     search_summary and one spectrum_query are held in memory at a time.
+ */
+PeptideStorePointer readPepXML(char *filename, PeptideStorePointer store);
 
 ///////////////////////////////////////////////////////////////////////////////
 //                       END OF FUNCTION DECLARATIONS                        //
@@ -292,68 +300,53 @@ char *modSequence(xmlNodePtr hit, xmlChar *seq, ModPointer mp){
 }
 
 
-PeptidePointer getSearchResults(PeptidePointer pp, xmlNodePtr msmsRunSummary,
-	ModPointer mp, char *mzXMLname){
-
-	xmlNodePtr child = NULL;
-	for(child=msmsRunSummary->children; child; child = child->next){
-		if(child->type == XML_ELEMENT_NODE &&
-			!xmlStrcmp(child->name, (const xmlChar *)SPECTRUM_QUERY) ){
-
-			xmlChar *scan = getAttribute( child, START_SCAN);
-			xmlNodePtr searchResult = downTo(child, SEARCH_RESULT);			
-			xmlNodePtr hit;
-			for(hit=searchResult->children; hit; hit = hit->next){
-				if(hit->type == XML_ELEMENT_NODE &&
-					!xmlStrcmp(hit->name, (const xmlChar *)SEARCH_HIT) ){
-					
-					xmlChar *rank = getAttribute( hit, HIT_RANK);
-					if(atoi( (char*)rank) == 1){
-						xmlChar *seq = getAttribute( hit, PEPTIDE);
-						char *modSeq = modSequence(hit, seq, mp);
-						pp = addPeptide(pp, mzXMLname, atoi((char*)scan),
-								modSeq);
-						free(modSeq);
-						xmlFree(seq); 
-					}				
-					xmlFree(rank); 
-				}
-			}
-			xmlFree(scan); 
+PeptideStorePointer getSearchResults(PeptideStorePointer store,
+	xmlNodePtr spectrumQuery, ModPointer mp, char *mzXMLname){
+
+	xmlNodePtr searchResult = downTo(spectrumQuery, SEARCH_RESULT);
+	if(searchResult == NULL){
+		return store;
+	}
+
+	xmlChar *scan = getAttribute( spectrumQuery, START_SCAN);
+	xmlChar *charge = getAttribute( spectrumQuery, ASSUMED_CHARGE);
+	xmlNodePtr hit;
+	for(hit=searchResult->children; hit; hit = hit->next){
+		if(hit->type == XML_ELEMENT_NODE &&
+			!xmlStrcmp(hit->name, (const xmlChar *)SEARCH_HIT) ){
+			
+			xmlChar *rank = getAttribute( hit, HIT_RANK);
+			if(atoi( (char*)rank) == 1){
+				xmlChar *seq = getAttribute( hit, PEPTIDE);
+				char *modSeq = modSequence(hit, seq, mp);
+				addPeptide(store, mzXMLname, atoi((char*)scan),
+						modSeq, charge? atoi((char*)charge) : 0);
+				free(modSeq);
+				xmlFree(seq); 
+			}				
+			xmlFree(rank); 
 		}
 	}
+	xmlFree(scan); 
+	xmlFree(charge);
 
-	return pp;
+	return store;
 }  
 
 
-PeptidePointer readPepXML(char *filename, PeptidePointer pp){
-
-	xmlDocPtr doc;
-	xmlNodePtr cur;
-
-	/*try to open pepXML file*/
-	openXML(&doc, filename);
+char *runName(xmlChar *base){
 
-	/*get properties of pepXML as a whole*/
-	cur = xmlDocGetRootElement(doc); 
-
-	/*get to msms_run_summary*/
-	cur = downTo(cur, MSMS_RUN_SUMMARY);
-	
-	/*convert base to mzXML filename*/
-	xmlChar * base = getAttribute(cur, BASE_NAME);
 	char *mzXMLname = NULL;
 
 	/*set offset to be one past the index of last path seperator*/
 	char * path = (char*)base;
-	int offset = 0;
-    if( (offset = (strrchr(path, '\\') - path + 1) ) < 0 &&
-        (offset = (strrchr(path, '/') - path + 1)) < 0 ) { 
-		offset = 0; 
+	char *separator = strrchr(path, '\\');
+	if(separator == NULL){
+		separator = strrchr(path, '/');
 	}
+	int offset = (separator == NULL)? 0 : separator - path + 1;
 
-	if(strstr((char*)base, SEQ_MXZML_DIR)){\
+	if(strstr((char*)base, SEQ_MXZML_DIR)){
 		/*if pepxml came from out2xml filename already has .mzXML_dta in name*/
 		size_t filename_length = xmlStrlen(base) - 4 + 1 - offset;
 		mzXMLname = (char*)malloc(filename_length*sizeof(char));
@@ -366,42 +359,108 @@ PeptidePointer readPepXML(char *filename, PeptidePointer pp){
 		strncpy(mzXMLname, (char*)base+offset, filename_length + 1);
 		strncpy(mzXMLname+filename_length, MZXML_EXT, strlen(MZXML_EXT)+1);
 	}
-	xmlFree(base);
+	return mzXMLname;
+}
 
-	/*get to search_summary and compile mod list*/
-	xmlNodePtr searchSummary = downTo(cur, SEARCH_SUMMARY);
-	ModPointer mp = getMods(searchSummary);
-	
-	/*populate */	
-	pp = getSearchResults(pp, cur, mp, mzXMLname);
-	puts(mzXMLname);
-	free(mzXMLname);
+
+PeptideStorePointer readPepXML(char *filename, PeptideStorePointer store){
+
+	xmlTextReaderPtr reader = xmlReaderForFile(filename, NULL, 0);
+	if(reader == NULL){
+		fprintf(stderr, "\nERROR: File: %s not parsed successfully.\n",
+			filename);
+		return store;
+	}
+
+	char *mzXMLname = NULL;
+	ModPointer mp = NULL;
+	bool haveMods = false;
+
+	/*
+	 * Walk the first msms_run_summary element by element. The search_summary
+	 * precedes the spectrum queries, so the mod list is complete before any
+	 * hit is converted. Each spectrum_query is expanded on its own and
+	 * released as the reader moves past it.
+	 */
+	int status = xmlTextReaderRead(reader);
+	while(status == 1){
+		const xmlChar *name = xmlTextReaderConstName(reader);
+		if(xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT){
+			status = xmlTextReaderRead(reader);
+		}else if(xmlTextReaderDepth(reader) == 1 &&
+			!xmlStrcmp(name, (const xmlChar *)MSMS_RUN_SUMMARY) ){
+			if(mzXMLname != NULL){
+				break;
+			}
+			/*convert base to mzXML filename*/
+			xmlChar *base = xmlTextReaderGetAttribute(reader, 
+				(const xmlChar *)BASE_NAME);
+			mzXMLname = runName(base);
+			xmlFree(base);
+			status = xmlTextReaderRead(reader);
+		}else if(xmlTextReaderDepth(reader) == 2 && mzXMLname != NULL &&
+			!xmlStrcmp(name, (const xmlChar *)SEARCH_SUMMARY) ){
+			/*compile mod list from the first search_summary*/
+			xmlNodePtr searchSummary = xmlTextReaderExpand(reader);
+			if(searchSummary != NULL && !haveMods){
+				mp = getMods(searchSummary);
+				haveMods = true;
+			}
+			status = xmlTextReaderNext(reader);
+		}else if(xmlTextReaderDepth(reader) == 2 && mzXMLname != NULL &&
+			!xmlStrcmp(name, (const xmlChar *)SPECTRUM_QUERY) ){
+			/*populate */	
+			xmlNodePtr spectrumQuery = xmlTextReaderExpand(reader);
+			if(spectrumQuery != NULL){
+				store = getSearchResults(store, spectrumQuery, mp, mzXMLname);
+			}
+			status = xmlTextReaderNext(reader);
+		}else{
+			status = xmlTextReaderRead(reader);
+		}
+	}
+	if(status < 0){
+		fprintf(stderr, "\nERROR: File: %s not parsed successfully.\n",
+			filename);
+	}
+
+	if(mzXMLname != NULL){
+		puts(mzXMLname);
+		free(mzXMLname);
+	}
 	
 	/*cleanup*/
-    xmlFreeDoc(doc); 
-	xmlCleanupParser();
+	xmlFreeTextReader(reader);
 	mp = delMods(mp);
 
-	return pp;
+	return store;
 }
 
 
-PeptidePointer parsePepXMLdir(char *dirName){
+PeptideStorePointer parsePepXMLdir(char *dirName, PeptideStorePointer store){
 
 	DIR *dp;
 	dp = opendir(dirName);
-	PeptidePointer pp = &TNILL;	
 	
+	char **paths = NULL;
+	int count = 0;
 	if(dp != NULL){
 		struct dirent *ep = NULL;
 		while ( (ep = readdir (dp)) ){
 			if(strstr(ep->d_name, PEPXML_EXT)){
 				puts(ep->d_name);
-				char fullPath[strlen(dirName) + strlen(ep->d_name) + 2];
+				paths = (char **)realloc(paths, (count+1) * sizeof(char *));
+				char *fullPath = (char *)malloc(strlen(dirName) +
+					strlen(ep->d_name) + 2);
+				if(paths == NULL || fullPath == NULL){
+					fprintf(stderr,
+						"\nERROR: Out of memory - cannot list %s!\n", dirName);
+					exit(1);
+				}
 				strcpy(fullPath, dirName);
 				strcat(fullPath, "/");
 				strcat(fullPath, ep->d_name);
-				pp = readPepXML(fullPath, pp);
+				paths[count++] = fullPath;
 			}
 		}
 		(void) closedir (dp);
@@ -409,7 +468,13 @@ PeptidePointer parsePepXMLdir(char *dirName){
 		fprintf(stderr, "\nERROR: Could not open directory: %s!\n", dirName);
 		exit(1);
 	}
-	
-	return pp;
+
+	/*pepXMLs are parsed concurrently, each into a store of its own*/
+	store = parseFiles(paths, count, readPepXML, store);
+	while(count > 0){
+		free(paths[--count]);
+	}
+	free(paths);
+	return store;
 }
 
@@ -0,0 +1,433 @@
+/*
+ * pool.c                                                                    
+ * ======                                                                    
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * A persistent pool of worker threads. Each worker owns a deque of chunks   
+ *     of task indices, takes work from the bottom of its own deque and      
+ *     steals from the top of the others' when it runs out.                  
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "pool.h"
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, realloc, free
+#include <pthread.h>
+
+#define DEQUE_SIZE 64 //initial number of chunks a deque holds
+#define CHUNKS_PER_WORKER 8 //chunks queued per worker when picking a size
+
+/*
+ * batch - The indices of a single poolFor or poolGraph call still to finish.
+ *     remaining is protected by poolLock.
+ */
+typedef struct batch {
+	PoolTask task;
+	void *arg;
+	int remaining;
+} Batch, *BatchPointer;
+
+/*
+ * chunk - A range [begin, end) of the indices of a batch.
+ */
+typedef struct chunk {
+	struct batch *batch;
+	int begin;
+	int end;
+} Chunk, *ChunkPointer;
+
+/*
+ * deque - A growable circular deque of chunks owned by a single worker.
+ */
+typedef struct deque {
+	pthread_mutex_t lock;
+	struct chunk *chunks;
+	int size;
+	int head; //index of the top chunk
+	int count;
+} Deque, *DequePointer;
+
+/*
+ * worker - A pool thread, its deque and scratch buffer.
+ */
+typedef struct worker {
+	pthread_t thread;
+	struct deque deque;
+	void *scratch;
+	size_t scratchSize;
+} Worker, *WorkerPointer;
+
+static WorkerPointer workers = NULL;
+static int workerCount = 0;
+static int pending = 0; //chunks queued over all deques
+static int stopping = 0;
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolWork = PTHREAD_COND_INITIALIZER;
+static __thread int workerId = 0;
+static __thread struct batch *currentBatch = NULL; //batch of the running task
+
+/*
+ * workerLoop - Run chunks until the pool is shut down, sleeping while there
+ *     are none queued.
+ */
+void *workerLoop(void *ptr);
+
+/*
+ * pushChunk - Add a chunk to the bottom of the deque. Return 0 on success,
+ *     -1 if the deque could not grow.
+ */
+int pushChunk(DequePointer dp, ChunkPointer cp);
+
+/*
+ * popChunk - Take the chunk at the bottom of the deque. Return 1 if a chunk
+ *     was taken, 0 if the deque was empty.
+ */
+int popChunk(DequePointer dp, ChunkPointer cp);
+
+/*
+ * stealChunk - Take the chunk at the top of the deque. Return 1 if a chunk
+ *     was taken, 0 if the deque was empty.
+ */
+int stealChunk(DequePointer dp, ChunkPointer cp);
+
+/*
+ * findChunk - Take a chunk from the worker's own deque or steal one from
+ *     another worker. Return 1 if a chunk was found, 0 otherwise.
+ */
+int findChunk(int id, ChunkPointer cp);
+
+/*
+ * runChunk - Run the task of every index of the chunk and mark them finished.
+ */
+void runChunk(int id, ChunkPointer cp);
+
+/*
+ * queueChunk - Queue a chunk on the worker's deque, running it immediately if
+ *     it could not be queued.
+ */
+void queueChunk(int id, ChunkPointer cp);
+
+/*
+ * waitBatch - Run chunks until every index of the batch has finished,
+ *     sleeping while there are none queued.
+ */
+void waitBatch(int id, BatchPointer bp);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+int initPool(int threads){
+	int i;
+	if(threads < 1){
+		threads = 1;
+	}
+	workers = (WorkerPointer)calloc(threads, sizeof(Worker));
+	if(workers == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create pool!\n");
+		return -1;
+	}
+	for(i = 0; i < threads; ++i){
+		pthread_mutex_init(&workers[i].deque.lock, NULL);
+		workers[i].deque.chunks = (ChunkPointer)malloc(DEQUE_SIZE *
+			sizeof(Chunk));
+		workers[i].deque.size = DEQUE_SIZE;
+		if(workers[i].deque.chunks == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot create pool!\n");
+			workerCount = i + 1;
+			delPool();
+			return -1;
+		}
+	}
+	workerCount = threads;
+	stopping = 0;
+	workerId = 0;
+
+	for(i = 1; i < threads; ++i){
+		if(pthread_create(&workers[i].thread, NULL, workerLoop,
+			(void *)(size_t)i)){
+			fprintf(stderr, "\nERROR: could not start pool thread %d\n", i);
+			workerCount = i;
+			break;
+		}
+	}
+	return 0;
+}
+
+
+void delPool(void){
+	int i;
+	if(workers == NULL){
+		return;
+	}
+	pthread_mutex_lock(&poolLock);
+	stopping = 1;
+	pthread_cond_broadcast(&poolWork);
+	pthread_mutex_unlock(&poolLock);
+	for(i = 1; i < workerCount; ++i){
+		pthread_join(workers[i].thread, NULL);
+	}
+	for(i = 0; i < workerCount; ++i){
+		pthread_mutex_destroy(&workers[i].deque.lock);
+		free(workers[i].deque.chunks);
+		free(workers[i].scratch);
+	}
+	free(workers);
+	workers = NULL;
+	workerCount = 0;
+	return;
+}
+
+
+void poolFor(int count, int chunk, PoolTask task, void *arg){
+	int i;
+	if(count <= 0){
+		return;
+	}
+	if(workerCount <= 1){
+		for(i = 0; i < count; ++i){
+			task(arg, i, 0);
+		}
+		return;
+	}
+	if(chunk <= 0){
+		chunk = count / (workerCount * CHUNKS_PER_WORKER);
+		chunk = chunk < 1 ? 1 : chunk;
+	}
+
+	Batch batch = {task, arg, count};
+
+	/*deal chunks out to every worker starting with the caller's own*/
+	int id = workerId;
+	int chunks = 0;
+	for(i = 0; i < count; i += chunk){
+		Chunk c = {&batch, i, i + chunk < count ? i + chunk : count};
+		queueChunk( (id + chunks) % workerCount, &c);
+		chunks++;
+	}
+	pthread_mutex_lock(&poolLock);
+	pthread_cond_broadcast(&poolWork);
+	pthread_mutex_unlock(&poolLock);
+
+	waitBatch(id, &batch);
+	return;
+}
+
+
+void poolGraph(int count, int *ready, int readyCount, PoolTask task,
+	void *arg){
+	int i;
+	if(count <= 0 || workers == NULL){
+		return;
+	}
+	Batch batch = {task, arg, count};
+
+	int id = workerId;
+	for(i = 0; i < readyCount; ++i){
+		Chunk c = {&batch, ready[i], ready[i] + 1};
+		queueChunk( (id + i) % workerCount, &c);
+	}
+	pthread_mutex_lock(&poolLock);
+	pthread_cond_broadcast(&poolWork);
+	pthread_mutex_unlock(&poolLock);
+
+	waitBatch(id, &batch);
+	return;
+}
+
+
+void poolSpawn(int index){
+	Chunk c = {currentBatch, index, index + 1};
+	queueChunk(workerId, &c);
+	pthread_mutex_lock(&poolLock);
+	pthread_cond_broadcast(&poolWork);
+	pthread_mutex_unlock(&poolLock);
+	return;
+}
+
+
+int poolWorker(void){
+	return workerId;
+}
+
+
+int poolSize(void){
+	return workerCount > 0 ? workerCount : 1;
+}
+
+
+void *poolScratch(size_t size){
+	if(workers == NULL){
+		return NULL;
+	}
+	WorkerPointer wp = workers + workerId;
+	if(wp->scratchSize < size){
+		void *tmp = realloc(wp->scratch, size);
+		if(tmp == NULL){
+			return NULL;
+		}
+		wp->scratch = tmp;
+		wp->scratchSize = size;
+	}
+	return wp->scratch;
+}
+
+
+void *workerLoop(void *ptr){
+	int id = (int)(size_t)ptr;
+	workerId = id;
+	for(;;){
+		Chunk c;
+		if(findChunk(id, &c)){
+			runChunk(id, &c);
+			continue;
+		}
+		pthread_mutex_lock(&poolLock);
+		while(pending == 0 && !stopping){
+			pthread_cond_wait(&poolWork, &poolLock);
+		}
+		if(pending == 0 && stopping){
+			pthread_mutex_unlock(&poolLock);
+			break;
+		}
+		pthread_mutex_unlock(&poolLock);
+	}
+	return NULL;
+}
+
+
+int pushChunk(DequePointer dp, ChunkPointer cp){
+	pthread_mutex_lock(&dp->lock);
+	if(dp->count == dp->size){
+		ChunkPointer tmp = (ChunkPointer)malloc(2 * dp->size * sizeof(Chunk));
+		if(tmp == NULL){
+			pthread_mutex_unlock(&dp->lock);
+			return -1;
+		}
+		int i;
+		for(i = 0; i < dp->count; ++i){
+			tmp[i] = dp->chunks[(dp->head + i) % dp->size];
+		}
+		free(dp->chunks);
+		dp->chunks = tmp;
+		dp->head = 0;
+		dp->size *= 2;
+	}
+	dp->chunks[(dp->head + dp->count) % dp->size] = *cp;
+	dp->count++;
+	pthread_mutex_unlock(&dp->lock);
+	return 0;
+}
+
+
+int popChunk(DequePointer dp, ChunkPointer cp){
+	int found = 0;
+	pthread_mutex_lock(&dp->lock);
+	if(dp->count > 0){
+		dp->count--;
+		*cp = dp->chunks[(dp->head + dp->count) % dp->size];
+		found = 1;
+	}
+	pthread_mutex_unlock(&dp->lock);
+	return found;
+}
+
+
+int stealChunk(DequePointer dp, ChunkPointer cp){
+	int found = 0;
+	pthread_mutex_lock(&dp->lock);
+	if(dp->count > 0){
+		*cp = dp->chunks[dp->head];
+		dp->head = (dp->head + 1) % dp->size;
+		dp->count--;
+		found = 1;
+	}
+	pthread_mutex_unlock(&dp->lock);
+	return found;
+}
+
+
+int findChunk(int id, ChunkPointer cp){
+	int i;
+	int found = popChunk(&workers[id].deque, cp);
+	for(i = 1; !found && i < workerCount; ++i){
+		found = stealChunk(&workers[(id + i) % workerCount].deque, cp);
+	}
+	if(found){
+		pthread_mutex_lock(&poolLock);
+		pending--;
+		pthread_mutex_unlock(&poolLock);
+	}
+	return found;
+}
+
+
+void runChunk(int id, ChunkPointer cp){
+	BatchPointer bp = cp->batch;
+	BatchPointer outer = currentBatch; //the chunk may run in a nested wait
+	currentBatch = bp;
+	int i;
+	for(i = cp->begin; i < cp->end; ++i){
+		bp->task(bp->arg, i, id);
+	}
+	currentBatch = outer;
+
+	pthread_mutex_lock(&poolLock);
+	bp->remaining -= cp->end - cp->begin;
+	if(bp->remaining == 0){
+		pthread_cond_broadcast(&poolWork); //wake the waiting thread
+	}
+	pthread_mutex_unlock(&poolLock);
+	return;
+}
+
+
+void queueChunk(int id, ChunkPointer cp){
+	/*count the chunk before it can be taken*/
+	pthread_mutex_lock(&poolLock);
+	pending++;
+	pthread_mutex_unlock(&poolLock);
+	if(pushChunk(&workers[id].deque, cp)){
+		pthread_mutex_lock(&poolLock);
+		pending--;
+		pthread_mutex_unlock(&poolLock);
+		runChunk(workerId, cp);
+	}
+	return;
+}
+
+
+void waitBatch(int id, BatchPointer bp){
+	for(;;){
+		Chunk c;
+		if(findChunk(id, &c)){
+			runChunk(id, &c);
+			continue;
+		}
+		/*sleep until chunks are queued or the batch finishes*/
+		pthread_mutex_lock(&poolLock);
+		while(pending == 0 && bp->remaining > 0){
+			pthread_cond_wait(&poolWork, &poolLock);
+		}
+		int remaining = bp->remaining;
+		pthread_mutex_unlock(&poolLock);
+		if(remaining == 0){
+			return;
+		}
+	}
+}
@@ -188,7 +188,8 @@ char *strrstr(const char* str1, const char *str2)
 
 
 int pep2prot(ProteinNodePointer *root, FastaPointer fasta,
-	PeptidePointer *peptides, double **pepQuant, double **spectralCounts,
+	PeptidePointer *peptides, MatrixPointer pepQuant,
+	MatrixPointer spectralCounts,
 	int peptideCount, int fileCount, char ***proteinMap){
 
 	(*proteinMap) = (char**)malloc(sizeof(char*)*peptideCount);
@@ -205,26 +206,25 @@ int pep2prot(ProteinNodePointer *root, FastaPointer fasta,
 		int isHeavy = 0;
 		if(!(arg || lys)){ //not looking for heavy stuff
 			isHeavy = -1;
-		}else if(peptides[i]->sequence[0] == '*'){ //is heavy
+		}else if(peptides[i]->heavy){ //is heavy
 			isHeavy = 1;
-		}else if(!strchr(peptides[i]->sequence, 'K') && 
-			!strchr(peptides[i]->sequence, 'R')){ //not K or R
+		}else if(!strchr(peptides[i]->stripped, 'K') && 
+			!strchr(peptides[i]->stripped, 'R')){ //not K or R
 			isHeavy = -1;
 		}else{ //we are looking for heavy stuff but this is light
 			isHeavy = 0;
 		}
-		char *stripped = stripMods(peptides[i]->sequence);
+		char *stripped = peptides[i]->stripped;
 		char *prots = findProtein(fasta, stripped);		
 		/*check to see if only one ; in returned string, i.e. only one protein
 		  in ';' seperated list.*/
 		if( prots != NULL && strstr(prots, ";;;") == strrstr(prots, ";;;") ){
 			trackCoverage(fasta, stripped);
 			//prots[strlen(prots)-1] = '\0'; //remove ';' from protein name
-			pnp = addProteinNode(pnp, prots, pepQuant[i], spectralCounts[i],
-				fileCount, isHeavy);
+			pnp = addProteinNode(pnp, prots, matrixRow(pepQuant, i),
+				matrixRow(spectralCounts, i), fileCount, isHeavy);
 		}
 		(*proteinMap)[i] = prots;
-		free(stripped);
 	}
 	
 	(*root) = pnp;
@@ -237,20 +237,22 @@ int pep2prot(ProteinNodePointer *root, FastaPointer fasta,
 }
 
 
-void prot2table(ProteinNodePointer pnp, double ***protQuant,
-	double ***protHQuant, double ***protLQuant, double ***protSpectralCounts,
-	int proteinCount, int fileCount){
+void prot2table(ProteinNodePointer pnp, MatrixPointer protQuant,
+	MatrixPointer protHQuant, MatrixPointer protLQuant,
+	MatrixPointer protSpectralCounts, int proteinCount, int fileCount){
 
 	int i, j;
 
 	for(i = 0; i < proteinCount; ++i){
-		memcpy( (*protSpectralCounts)[i], pnp->spectralCounts,
+		memcpy( matrixRow(protSpectralCounts, i), pnp->spectralCounts,
 			fileCount*sizeof(double) );
-		memcpy( (*protLQuant)[i], pnp->light, fileCount*sizeof(double) );
-		memcpy( (*protHQuant)[i], pnp->heavy, fileCount*sizeof(double) );
+		memcpy( matrixRow(protLQuant, i), pnp->light,
+			fileCount*sizeof(double) );
+		memcpy( matrixRow(protHQuant, i), pnp->heavy,
+			fileCount*sizeof(double) );
+		double *quant = matrixRow(protQuant, i);
 		for(j = 0; j < fileCount; ++j){
-			(*protQuant)[i][j] = 
-				pnp->intensities[j] + pnp->light[j] + pnp->heavy[j];
+			quant[j] = pnp->intensities[j] + pnp->light[j] + pnp->heavy[j];
 		}
 		pnp = pnp->next;
 	}
@@ -270,7 +272,7 @@ ProteinNodePointer delProteinList(ProteinNodePointer pnp){
 
 
 void printProtTable(ProteinNodePointer pnp, SpectraFileNodePointer filelist,
-	int proteinCount, int fileCount, double **table, char *filename){
+	int proteinCount, int fileCount, MatrixPointer table, char *filename){
 
 	FILE *fp = fopen(filename, "w");
 	if (fp == NULL)	{
@@ -287,8 +289,9 @@ void printProtTable(ProteinNodePointer pnp, SpectraFileNodePointer filelist,
 	int j;
 	for(i = 0; i < proteinCount; ++i){
 		fprintf(fp, "%s", pnp->id);
+		double *row = matrixRow(table, i);
 		for(j = 0; j < fileCount; ++j){
-			fprintf(fp, "\t%.6e", table[i][j]);
+			fprintf(fp, "\t%.6e", row[j]);
 		}
 		fprintf(fp, "\n");
 		pnp = pnp->next;
@@ -0,0 +1,241 @@
+/*
+ * records.c                                                                 
+ * =========                                                                 
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Memory mapped reader of delimited text files. Records and fields are      
+ *     found with memchr, which scans a word or vector at a time, and are    
+ *     handed out as spans of the mapping so the file is never copied.       
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#define _POSIX_C_SOURCE 200809L //mmap, posix_madvise
+
+#include "records.h"
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, realloc, free
+#include <string.h> //memchr, memcmp, memcpy, strlen
+#include <ctype.h> //isspace, isdigit
+#include <fcntl.h> //open
+#include <unistd.h> //close
+#include <sys/mman.h> //mmap, munmap, posix_madvise
+#include <sys/stat.h> //fstat
+
+/*
+ * nextField - Return the end of the field of record starting at start, the
+ *     next delim or the end of the record.
+ */
+const char *nextField(const char *start, const char *end, char delim);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+RecordsPointer newRecords(char *filename){
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0){
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0){
+		close(fd);
+		return NULL;
+	}
+	RecordsPointer rp = (RecordsPointer)malloc(sizeof(Records));
+	if(rp == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot read %s!\n",
+			filename);
+		close(fd);
+		return NULL;
+	}
+	rp->data = NULL;
+	rp->size = (size_t)st.st_size;
+	if(rp->size > 0){
+		void *data = mmap(NULL, rp->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED){
+			free(rp);
+			close(fd);
+			return NULL;
+		}
+		/*records are read front to back, let the kernel read ahead*/
+		posix_madvise(data, rp->size, POSIX_MADV_SEQUENTIAL);
+		rp->data = (const char *)data;
+	}
+
+	/*the mapping outlives the descriptor*/
+	close(fd);
+	return rp;
+}
+
+
+RecordsPointer delRecords(RecordsPointer rp){
+	if(rp == NULL){
+		return NULL;
+	}
+	if(rp->data != NULL){
+		munmap((void *)rp->data, rp->size);
+	}
+	free(rp);
+	return NULL;
+}
+
+
+const char *nextRecord(const char **cursor, const char *end, int *length){
+	const char *record = *cursor;
+	if(record == NULL || record >= end){
+		return NULL;
+	}
+	const char *newline = (const char *)memchr(record, '\n', end - record);
+	const char *last = newline ? newline : end;
+	*cursor = newline ? newline + 1 : end;
+	if(last > record && last[-1] == '\r'){
+		--last;
+	}
+	*length = (int)(last - record);
+	return record;
+}
+
+
+const char *nextField(const char *start, const char *end, char delim){
+	const char *found = (const char *)memchr(start, delim, end - start);
+	return found ? found : end;
+}
+
+
+int splitRecord(const char *record, int length, char delim, bool collapse,
+	FieldPointer fields, int max){
+	const char *end = record + length;
+	const char *start = record;
+	int count = 0;
+	if(length == 0){
+		return 0;
+	}
+	while(count < max){
+		if(collapse){
+			while(start < end && *start == delim){
+				++start;
+			}
+			if(start == end){
+				break;
+			}
+		}
+		const char *stop = nextField(start, end, delim);
+		fields[count].start = start;
+		fields[count].length = (int)(stop - start);
+		++count;
+		if(stop == end){
+			break;
+		}
+		start = stop + 1;
+	}
+	return count;
+}
+
+
+int findColumn(FieldPointer header, int count, const char *name,
+	int fallback){
+	int i;
+	for(i = 0; i < count; ++i){
+		if(fieldIs(header + i, name)){
+			return i;
+		}
+	}
+	return fallback;
+}
+
+
+int chunkRecords(RecordsPointer rp, size_t offset, size_t chunkSize,
+	size_t **bounds){
+	int chunkCount = 0;
+	int size = 8;
+	size_t *b = (size_t *)malloc(size * sizeof(size_t));
+	if(b == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot chunk records!\n");
+		exit(1);
+	}
+	b[0] = offset < rp->size ? offset : rp->size;
+	while(b[chunkCount] < rp->size){
+		size_t next = b[chunkCount] + chunkSize;
+		if(next >= rp->size){
+			next = rp->size;
+		}else{
+			/*move the boundary past the end of the record it falls in*/
+			const char *newline = (const char *)memchr(rp->data + next,
+				'\n', rp->size - next);
+			next = newline ? (size_t)(newline - rp->data) + 1 : rp->size;
+		}
+		if(chunkCount + 2 > size){
+			size *= 2;
+			size_t *grown = (size_t *)realloc(b, size * sizeof(size_t));
+			if(grown == NULL){
+				fprintf(stderr,
+					"\nERROR: Out of memory - cannot chunk records!\n");
+				exit(1);
+			}
+			b = grown;
+		}
+		b[++chunkCount] = next;
+	}
+	*bounds = b;
+	return chunkCount;
+}
+
+
+bool fieldIs(FieldPointer field, const char *text){
+	return (int)strlen(text) == field->length &&
+		!memcmp(field->start, text, field->length);
+}
+
+
+int fieldInt(FieldPointer field){
+	const char *c = field->start;
+	const char *end = c + field->length;
+	int sign = 1;
+	int value = 0;
+	while(c < end && isspace((unsigned char)*c)){
+		++c;
+	}
+	if(c < end && (*c == '-' || *c == '+')){
+		sign = (*c == '-') ? -1 : 1;
+		++c;
+	}
+	while(c < end && isdigit((unsigned char)*c)){
+		value = 10 * value + (*c - '0');
+		++c;
+	}
+	return sign * value;
+}
+
+
+char *fieldString(FieldPointer field, const char *suffix, char **buffer,
+	int *size){
+	int suffixLength = suffix ? strlen(suffix) : 0;
+	int needed = field->length + suffixLength + 1;
+	if(*buffer == NULL || *size < needed){
+		char *grown = (char *)realloc(*buffer, needed);
+		if(grown == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot copy field!\n");
+			exit(1);
+		}
+		*buffer = grown;
+		*size = needed;
+	}
+	memcpy(*buffer, field->start, field->length);
+	memcpy(*buffer + field->length, suffix ? suffix : "", suffixLength + 1);
+	return *buffer;
+}
@@ -0,0 +1,270 @@
+/*
+ * registry.c                                                                
+ * ==========                                                                
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for interning spectra file names as dense integer ids and for   
+ *     resolving the names used by search results against a user supplied    
+ *     list of data files by basename.                                       
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "registry.h"
+#include "arena.h" //ArenaPointer, newArena, arenaString, delArena
+#include "global.h" //dataList, dataCount
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, calloc, realloc, free, exit
+#include <string.h> //strcmp, strrchr, strstr
+
+#define TABLE_SIZE 64 //initial slots of a name table, a power of two
+#define REGISTRY_SIZE 16 //initial names of a registry
+
+/*
+ * hashName - FNV-1a hash of a file name.
+ */
+uint32_t hashName(const char *name);
+
+/*
+ * initTable - Allocate the slots of an empty name table. Return 0 on success,
+ *     -1 if out of memory.
+ */
+int initTable(NameTablePointer nt);
+
+/*
+ * freeTable - Free the slots of the name table.
+ */
+void freeTable(NameTablePointer nt);
+
+/*
+ * findKey - Return the slot of the table holding key, or the empty slot where
+ *     it would be inserted.
+ */
+int findKey(NameTablePointer nt, const char *key, uint32_t hash);
+
+/*
+ * insertKey - Add key to the table with value unless it is present, growing
+ *     the table as needed. Exits if out of memory.
+ */
+void insertKey(NameTablePointer nt, const char *key, uint32_t hash,
+	int value);
+
+/*
+ * baseName - Return the part of path after its last path separator.
+ */
+const char *baseName(const char *path);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+FileRegistryPointer newFileRegistry(void){
+	FileRegistryPointer fr = (FileRegistryPointer)calloc(1,
+		sizeof(FileRegistry));
+	if(fr == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create registry!\n");
+		return NULL;
+	}
+	fr->capacity = REGISTRY_SIZE;
+	fr->names = (char **)malloc(fr->capacity * sizeof(char *));
+	fr->strings = newArena(0);
+	if(fr->names == NULL || fr->strings == NULL || initTable(&fr->ids) ||
+		initTable(&fr->resolved) || initTable(&fr->basenames)){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create registry!\n");
+		return delFileRegistry(fr);
+	}
+
+	/*the first path with a given basename wins, as with a linear search*/
+	size_t i;
+	for(i = 0; dataList != NULL && i < dataCount; ++i){
+		const char *base = baseName(dataList[i]);
+		insertKey(&fr->basenames, base, hashName(base), (int)i);
+	}
+	return fr;
+}
+
+
+FileRegistryPointer delFileRegistry(FileRegistryPointer fr){
+	if(fr == NULL){
+		return NULL;
+	}
+	freeTable(&fr->ids);
+	freeTable(&fr->resolved);
+	freeTable(&fr->basenames);
+	fr->strings = delArena(fr->strings);
+	free(fr->names);
+	free(fr);
+	fr = NULL;
+	return fr;
+}
+
+
+int internFile(FileRegistryPointer fr, const char *name){
+	uint32_t hash = hashName(name);
+	int slot = findKey(&fr->ids, name, hash);
+	if(fr->ids.keys[slot] != NULL){
+		return fr->ids.values[slot];
+	}
+
+	if(fr->count == fr->capacity){
+		char **names = (char **)realloc(fr->names,
+			2 * fr->capacity * sizeof(char *));
+		if(names == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot register %s!\n",
+				name);
+			exit(1);
+		}
+		fr->names = names;
+		fr->capacity *= 2;
+	}
+	char *copy = arenaString(fr->strings, name);
+	if(copy == NULL){
+		exit(1);
+	}
+	fr->names[fr->count] = copy;
+	insertKey(&fr->ids, copy, hash, fr->count);
+	return fr->count++;
+}
+
+
+int resolveFile(FileRegistryPointer fr, const char *name){
+	if(dataList == NULL){
+		return internFile(fr, name);
+	}
+
+	uint32_t hash = hashName(name);
+	int slot = findKey(&fr->resolved, name, hash);
+	if(fr->resolved.keys[slot] != NULL){
+		return fr->resolved.values[slot];
+	}
+
+	/*names are usually the basename of a data list path, anything else
+	falls back to the first path containing the name*/
+	int index = -1;
+	const char *base = baseName(name);
+	int b = findKey(&fr->basenames, base, hashName(base));
+	if(fr->basenames.keys[b] != NULL &&
+		strstr(dataList[fr->basenames.values[b]], name)){
+		index = fr->basenames.values[b];
+	}
+	size_t i;
+	for(i = 0; index < 0 && i < dataCount; ++i){
+		if(strstr(dataList[i], name)){
+			index = (int)i;
+		}
+	}
+
+	int id = index < 0? -1 : internFile(fr, dataList[index]);
+	char *copy = arenaString(fr->strings, name);
+	if(copy == NULL){
+		exit(1);
+	}
+	insertKey(&fr->resolved, copy, hash, id);
+	return id;
+}
+
+
+char *fileName(FileRegistryPointer fr, int id){
+	return fr->names[id];
+}
+
+
+uint32_t hashName(const char *name){
+	uint32_t hash = 2166136261u;
+	while(*name != '\0'){
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+int initTable(NameTablePointer nt){
+	nt->keys = (const char **)calloc(TABLE_SIZE, sizeof(const char *));
+	nt->hashes = (uint32_t *)malloc(TABLE_SIZE * sizeof(uint32_t));
+	nt->values = (int *)malloc(TABLE_SIZE * sizeof(int));
+	nt->size = TABLE_SIZE;
+	nt->count = 0;
+	if(nt->keys == NULL || nt->hashes == NULL || nt->values == NULL){
+		return -1;
+	}
+	return 0;
+}
+
+
+void freeTable(NameTablePointer nt){
+	free(nt->keys);
+	free(nt->hashes);
+	free(nt->values);
+	nt->keys = NULL;
+	nt->hashes = NULL;
+	nt->values = NULL;
+}
+
+
+int findKey(NameTablePointer nt, const char *key, uint32_t hash){
+	int mask = nt->size - 1;
+	int i = hash & mask;
+	while(nt->keys[i] != NULL && (nt->hashes[i] != hash ||
+		strcmp(key, nt->keys[i]))){
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+
+void insertKey(NameTablePointer nt, const char *key, uint32_t hash,
+	int value){
+	int i;
+	if(2 * (nt->count + 1) > nt->size){
+		NameTable grown = {NULL, NULL, NULL, 2 * nt->size, nt->count};
+		grown.keys = (const char **)calloc(grown.size, sizeof(const char *));
+		grown.hashes = (uint32_t *)malloc(grown.size * sizeof(uint32_t));
+		grown.values = (int *)malloc(grown.size * sizeof(int));
+		if(grown.keys == NULL || grown.hashes == NULL || grown.values == NULL){
+			fprintf(stderr, "\nERROR: Out of memory - cannot grow registry!\n");
+			exit(1);
+		}
+		for(i = 0; i < nt->size; ++i){
+			if(nt->keys[i] != NULL){
+				int j = findKey(&grown, nt->keys[i], nt->hashes[i]);
+				grown.keys[j] = nt->keys[i];
+				grown.hashes[j] = nt->hashes[i];
+				grown.values[j] = nt->values[i];
+			}
+		}
+		freeTable(nt);
+		*nt = grown;
+	}
+	i = findKey(nt, key, hash);
+	if(nt->keys[i] == NULL){
+		nt->keys[i] = key;
+		nt->hashes[i] = hash;
+		nt->values[i] = value;
+		nt->count++;
+	}
+}
+
+
+const char *baseName(const char *path){
+	const char *slash = strrchr(path, '/');
+	const char *backslash = strrchr(path, '\\');
+	if(backslash != NULL && (slash == NULL || backslash > slash)){
+		slash = backslash;
+	}
+	return slash == NULL? path : slash + 1;
+}
@@ -0,0 +1,181 @@
+/*
+ * summary.c                                                                 
+ * =========                                                                 
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for folding the ms1 hits of a peptide in a single LC-MS run     
+ *     into a fixed size summary once the run has been searched for it.      
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "summary.h"
+#include "global.h" //corrCutOff, peakWindow, quantWindow
+#include "hits.h" //HitBufferPointer
+#include "mzXML.h" //MZXMLPointer
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //calloc, free
+#include <math.h> //fabs, floor
+
+#define SAME_RT 1e-6 //seconds within which a window centre is a kept centre
+
+/*
+ * windowIntensity - Return the intensity of the valid hits of the buffer
+ *     within quantWindow of the retention time centre.
+ */
+double windowIntensity(HitBufferPointer hb, int width, MZXMLPointer mzXML,
+	double centre);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+Ms1SummaryPointer newMs1Summaries(int fileCount){
+	Ms1SummaryPointer ms = (Ms1SummaryPointer)calloc(
+		fileCount ? fileCount : 1, sizeof(Ms1Summary));
+	if(ms == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create summaries!\n");
+	}
+	return ms;
+}
+
+
+Ms1SummaryPointer delMs1Summaries(Ms1SummaryPointer ms){
+	free(ms);
+	ms = NULL;
+	return ms;
+}
+
+
+void anchorSummary(Ms1SummaryPointer ms, double rt){
+	ms->anchored = 1;
+	ms->anchorRT = rt;
+	return;
+}
+
+
+void summariseHits(Ms1SummaryPointer ms, HitBufferPointer hb, int width,
+	MZXMLPointer mzXML){
+	int h, k;
+	ms->hits = hb->count;
+	if(hb->count == 0){
+		return;
+	}
+
+	/*the apex and its neighbour as the ms1 rt table finds them*/
+	double maxIntensity = 0;
+	double maxRT = 0;
+	for(h = 0; h < hb->count; ++h){
+		double totalIntensity = 0;
+		for(k = 0; k < width; ++k){
+			totalIntensity+=hb->intensity[h*width + k];
+		}
+		if(totalIntensity > maxIntensity){
+			maxIntensity = totalIntensity;
+			maxRT = mzXML->scans[hb->scanNum[h]-1]->retentionTime;
+		}
+	}
+	ms->apexRT = maxRT;
+	ms->apexIntensity = maxIntensity;
+	ms->neighbour = 0;
+	for(h = 0; h < hb->count; ++h){
+		double rt = mzXML->scans[hb->scanNum[h]-1]->retentionTime;
+		if(fabs(rt - maxRT) < peakWindow && rt != maxRT){
+			ms->neighbour = 1;
+		}
+	}
+
+	/*windows about the apex or anchor are summed exactly, others from bins
+	about the apex*/
+	ms->apexWindow = windowIntensity(hb, width, mzXML, ms->apexRT);
+	if(ms->anchored){
+		ms->anchorWindow = windowIntensity(hb, width, mzXML, ms->anchorRT);
+	}
+	double binWidth = 4.0*quantWindow/SUMMARY_BINS;
+	ms->binStart = ms->apexRT - SUMMARY_BINS/2 * binWidth;
+	for(h = 0; h < hb->count; ++h){
+		int valid = 0;
+		double total = 0;
+		for(k = 0; k < width; ++k){
+			if(hb->corr[h*width + k] >= corrCutOff){
+				valid = 1;
+			}
+			total += hb->intensity[h*width + k];
+		}
+		double rt = mzXML->scans[hb->scanNum[h]-1]->retentionTime;
+		int bin = (int)floor( (rt - ms->binStart) / binWidth);
+		if(valid && bin >= 0 && bin < SUMMARY_BINS){
+			ms->bins[bin] += total;
+		}
+	}
+	return;
+}
+
+
+double windowIntensity(HitBufferPointer hb, int width, MZXMLPointer mzXML,
+	double centre){
+	int h, k;
+	double totalIntensity = 0;
+	for(h = 0; h < hb->count; ++h){
+		double rt = mzXML->scans[hb->scanNum[h]-1]->retentionTime;
+		if(fabs(rt - centre) < quantWindow){
+			int valid = 0;
+			double total = 0;
+			for(k = 0; k < width; k++){
+				if(hb->corr[h*width + k] >= corrCutOff){
+					valid = 1;
+				}
+				total += hb->intensity[h*width + k];
+			}
+			totalIntensity+= valid == 1? total : 0;
+		}
+	}
+	return totalIntensity;
+}
+
+
+double summaryApexRT(Ms1SummaryPointer ms){
+	return (ms->hits == 0 || !ms->neighbour) ? 0 : ms->apexRT;
+}
+
+
+double summaryIntensity(Ms1SummaryPointer ms, double centre){
+	double width = 4.0*quantWindow/SUMMARY_BINS;
+	double total = 0;
+	int i;
+	if(ms->hits == 0){
+		return 0;
+	}
+	if(fabs(centre - ms->apexRT) < SAME_RT){
+		return ms->apexWindow;
+	}
+	if(ms->anchored && fabs(centre - ms->anchorRT) < SAME_RT){
+		return ms->anchorWindow;
+	}
+	for(i = 0; i < SUMMARY_BINS; ++i){
+		double low = ms->binStart + i*width;
+		double high = low + width;
+		double overlapLow = low > centre - quantWindow ?
+			low : centre - quantWindow;
+		double overlapHigh = high < centre + quantWindow ?
+			high : centre + quantWindow;
+		if(overlapHigh > overlapLow){
+			total += ms->bins[i] * (overlapHigh - overlapLow)/width;
+		}
+	}
+	return total;
+}
@@ -0,0 +1,272 @@
+/*
+ * xic.c                                                                     
+ * =====                                                                     
+ *  ____                _____                            __       ___        
+ * /\  _`\             /\  __`\                         /\ \__  /'___`\      
+ * \ \ \L\ \ __   _____\ \ \/\ \  __  __     __      ___\ \ ,_\/\_\ /\ \     
+ *  \ \ ,__/'__`\/\ '__`\ \ \ \ \/\ \/\ \  /'__`\  /' _ `\ \ \/\/_/// /__    
+ *   \ \ \/\  __/\ \ \L\ \ \ \\'\\ \ \_\ \/\ \L\.\_/\ \/\ \ \ \_  // /_\ \   
+ *    \ \_\ \____\\ \ ,__/\ \___\_\ \____/\ \__/.\_\ \_\ \_\ \__\/\______/+  
+ *     \/_/\/____/ \ \ \/  \/__//_/\/___/  \/__/\/_/\/_/\/_/\/__/\/_____/     
+ *                  \ \_\                                                    
+ *                   \/_/                                                    
+ *                                                                           
+ *                              Andrew Lugowski                              
+ *                   Emili Lab at the University of Toronto                  
+ *                                                                           
+ * Version 1.00 (Aug 22, 2013)                                               
+ *                                                                           
+ * Functions for building a store of ms1 peaks for a single LC-MS run and    
+ *     for extracting ion chromatograms from it. The peak matching here is   
+ *     shared with the scan by scan ms1 search.                              
+ *                                                                           
+ * +ASCII art via Text ASCII Art Generator by Patrick Gillespie              
+ */
+
+#include "xic.h"
+#include "calibrate.h" //calibrateMz, calibratedTolerance
+
+#include <stdio.h> //fprintf
+#include <stdlib.h> //malloc, free, exit
+#include <string.h> //memcpy
+#include <math.h> //fabs
+
+/*
+ * binSearch - a traditional binary search except rather than direct equality
+ *     we require mzs be within tolerance (relative) of each other.
+ */
+float *binSearch(float mz, float *head, float *tail, double tolerance);
+
+/*
+ * sumPeak - Given a pointer to the intensity value of either extremes of a
+ *     peak, sum all peaks belonging to the peak by progressing through the
+ *     intensity left in the direction specified. A -1 direction means
+ *     left and a +1 direction means right. The peak boundary is set at the
+ *     nearest zero intensity or next nondecreasing intensity value.
+ */
+float sumPeak(float *point, int direction);
+
+///////////////////////////////////////////////////////////////////////////////
+//                       END OF FUNCTION DECLARATIONS                        //
+///////////////////////////////////////////////////////////////////////////////
+
+XicStorePointer newXicStore(MZXMLPointer mzXML){
+	XicStorePointer xs = (XicStorePointer)malloc(sizeof(XicStore));
+	if(xs == NULL){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create XIC store!\n");
+		return NULL;
+	}
+
+	/*count ms1 scans and peaks so the store can be allocated at once*/
+	int i;
+	int scanCount = 0;
+	int peakCount = 0;
+	for(i = 0; i < mzXML->scanCount; ++i){
+		ScanPointer sp = mzXML->scans[i];
+		if(sp->msLevel == 1 && sp->peaksCount >= MIN_PEAK_COUNT &&
+			sp->mzList != NULL){
+			scanCount++;
+			peakCount += sp->peaksCount;
+		}
+	}
+
+	xs->scanCount = scanCount;
+	xs->scanNum = (int *)malloc(scanCount * sizeof(int));
+	xs->rt = (float *)malloc(scanCount * sizeof(float));
+	xs->offset = (int *)malloc( (scanCount + 1) * sizeof(int));
+	xs->mz = (float *)malloc(peakCount * sizeof(float));
+	xs->intensity = (float *)malloc(peakCount * sizeof(float));
+	if(xs->scanNum == NULL || xs->rt == NULL || xs->offset == NULL ||
+		(peakCount && (xs->mz == NULL || xs->intensity == NULL)) ){
+		fprintf(stderr, "\nERROR: Out of memory - cannot create XIC store!\n");
+		return delXicStore(xs);
+	}
+
+	int j = 0;
+	xs->offset[0] = 0;
+	for(i = 0; i < mzXML->scanCount; ++i){
+		ScanPointer sp = mzXML->scans[i];
+		if(sp->msLevel == 1 && sp->peaksCount >= MIN_PEAK_COUNT &&
+			sp->mzList != NULL){
+			xs->scanNum[j] = sp->scanNum;
+			xs->rt[j] = sp->retentionTime;
+			memcpy(xs->mz + xs->offset[j], sp->mzList,
+				sp->peaksCount * sizeof(float));
+			memcpy(xs->intensity + xs->offset[j], sp->intList,
+				sp->peaksCount * sizeof(float));
+			xs->offset[j+1] = xs->offset[j] + sp->peaksCount;
+			j++;
+		}
+	}
+	return xs;
+}
+
+
+XicStorePointer delXicStore(XicStorePointer xs){
+	if(xs == NULL){
+		return NULL;
+	}
+	free(xs->scanNum);
+	free(xs->rt);
+	free(xs->offset);
+	free(xs->mz);
+	free(xs->intensity);
+	free(xs);
+	xs = NULL;
+	return xs;
+}
+
+
+float *binSearch(float mz, float *head, float *tail, double tolerance){
+	while(head < tail && mz > *head && mz < *tail){
+		float *mid = head + (tail-head)/2; //find middle
+		if(fabs(*mid - mz)/mz < tolerance){
+			return mid;
+		}else if(mz > *mid){
+			head = mid+1;
+		}else{
+			tail= mid-1;
+		}		
+	}
+	return NULL;
+}
+
+
+float sumPeak(float *point, int direction){
+	if(direction != -1 && direction != 1){
+		fprintf(stderr, "The direction passed to sumPeak was not +/-1\n");
+		exit(EXIT_FAILURE);
+	}
+	int goinDown = 0; //are we moving up the side of the peak
+	float total_intensity = 0;
+	while(point != NULL){
+		total_intensity += *point;
+		float *next = point + direction;
+
+		if(*next < 0.001)
+			break;
+		if( !goinDown && (*next - *point ) < 0)
+			goinDown = 1;
+		else if( goinDown && (*next - *point ) > 0 )
+			break;
+		point = next;
+	}
+	return total_intensity;
+}
+
+
+float peakIntensity(float mz, float *mzList, float *intList, int peaksCount,
+	double tolerance){
+	float *head = mzList;
+	float *tail = head + peaksCount - 1;
+	float *index = binSearch(mz, head, tail, tolerance);
+	if(index == NULL){
+		return 0;
+	}
+
+	// find value closest to mz
+	float *bestHit = index;
+	float bestError = fabs( (*index) - mz) / mz;
+	/*check lower adjacent indices*/
+	float *tempIndex = index - 1;
+	while(tempIndex >= head){
+		float ppmError = fabs( (*tempIndex) - mz)/ mz;
+		if(ppmError >= tolerance){break;}
+		if(ppmError < bestError){
+			bestHit = tempIndex;
+			bestError = ppmError;
+		}
+		tempIndex--;
+	}
+	/*check higher adjacent indices*/
+	tempIndex = index + 1;
+	while(tempIndex <= tail){
+		float ppmError = fabs( (*tempIndex) - mz)/ mz;
+		if(ppmError >= tolerance){break;}
+		if(ppmError < bestError){
+			bestHit = tempIndex;
+			bestError = ppmError;
+		}
+		tempIndex++;
+	}
+
+	if(intList[bestHit-head] < 0.001){
+		//look left
+		float *tempLindex = bestHit-1;
+		float ppmLerror = 1;
+		while((tempLindex >= head) &&
+			(ppmLerror = fabs( (*tempLindex) - mz)/ mz) <= tolerance &&
+			(intList[tempLindex-head] < 0.001)){
+
+			--tempLindex;
+		}
+		float *tempRindex = bestHit+1;
+		float ppmRerror = 1;
+		while((tempRindex <= tail) &&
+			(ppmRerror = fabs( (*tempRindex) - mz)/ mz) <= tolerance &&
+			(intList[tempRindex-head] < 0.001)){
+
+			++tempRindex;
+		}
+		bestHit = ppmLerror < ppmRerror ? tempLindex : tempRindex;
+	}
+
+	// I have found the most precise recorded mz within the
+	// theoretical window. If at least part of the peak falls here
+	// then sum that peak.
+	float *bestInt = intList+(bestHit-head);
+	if(intList[bestHit-head] > 0){
+		tempIndex = bestInt;
+		if( *tempIndex < *(tempIndex+1)){
+			while(*(tempIndex-1) < *tempIndex){
+				--tempIndex;
+			}
+			return sumPeak(tempIndex, 1);
+		}else if(*tempIndex > *(tempIndex+1)){
+			while(*(tempIndex+1) < *tempIndex){
+				++tempIndex;
+			}
+			return sumPeak(tempIndex, -1);
+		}
+	}
+	return 0;
+}
+
+
+float peakApex(float mz, float *mzList, float *intList, int peaksCount,
+	double tolerance){
+	float *head = mzList;
+	float *tail = head + peaksCount - 1;
+	float *index = binSearch(mz, head, tail, tolerance);
+	if(index == NULL){
+		return 0;
+	}
+
+	/*walk to the lowest mz within tolerance then scan the window*/
+	while(index > head && fabs(*(index-1) - mz)/mz < tolerance){
+		--index;
+	}
+	float apexMz = 0;
+	float apexIntensity = 0;
+	for(; index <= tail && fabs(*index - mz)/mz < tolerance; ++index){
+		if(intList[index-head] > apexIntensity){
+			apexIntensity = intList[index-head];
+			apexMz = *index;
+		}
+	}
+	return apexMz;
+}
+
+
+void xicTrace(XicStorePointer xs, float mz, int first, int last,
+	struct calibration *cal, float *trace){
+	double tolerance = calibratedTolerance(cal);
+	int i;
+	for(i = first; i < last; ++i){
+		trace[i - first] = peakIntensity(calibrateMz(cal, mz, xs->rt[i]),
+			xs->mz + xs->offset[i], xs->intensity + xs->offset[i],
+			xs->offset[i+1] - xs->offset[i], tolerance);
+	}
+	return;
+}
+